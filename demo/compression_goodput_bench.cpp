@@ -0,0 +1,121 @@
+#include "compression.hpp"
+#include "udp_socket.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+// chunks are sent over loopback paced to this rate, as on a bandwidth bound link.
+static const auto link_rate_mbps = 100.0;
+static const auto chunk_size = size_t(1400);
+static const auto chunk_count = size_t(20000);
+
+// to fill buffer with log lines, or random bytes.
+static void make_data(EZSock::Buffer & data, bool is_random, uint64_t seed) {
+    auto random_engine = std::mt19937_64(seed);
+    if(is_random){
+        for(size_t i = 0; i < data.get_buf_size(); i ++) data[i] = uint8_t(random_engine());
+        return;
+    }
+
+    const char * levels[] = {"INFO", "WARN", "DEBUG"};
+    const char * paths[] = {"/api/v1/items", "/api/v1/users", "/healthz", "/api/v2/orders"};
+    auto text = std::string();
+    while(text.size() < data.get_buf_size()){
+        text += "ts=" + std::to_string(1666000000 + random_engine() % 100000) + " level=" + levels[random_engine() % 3];
+        text += " service=gateway path=" + std::string(paths[random_engine() % 4]) + " status=200 latency_us=" + std::to_string(random_engine() % 5000) + "\n";
+    }
+    std::memcpy(data.get_buf_base(), text.data(), data.get_buf_size());
+}
+
+// to send all chunks of data through a paced link, print ratio & goodput seen by receiver.
+static void run(const char * name, const EZSock::Buffer & data, EZSock::CompressionCodec codec, const EZSock::CompressionDictionary * dictionary) {
+    auto loopback = EZSock::IPv4_Address::cstr_to_ipv4_address("127.0.0.1");
+    auto sender_address = EZSock::SocketAddress_IPv4(loopback, 10751);
+    auto receiver_address = EZSock::SocketAddress_IPv4(loopback, 10750);
+
+    auto sender_socket = EZSock::UDPSocket(64);
+    auto receiver_socket = EZSock::UDPSocket(EZSock::Compressor::get_max_frame_size(chunk_size));
+    sender_socket.bind(sender_address);
+    receiver_socket.bind(receiver_address);
+
+    auto sender = EZSock::CompressedSender(sender_socket, codec, chunk_size);
+    auto receiver = EZSock::CompressedReceiver(receiver_socket);
+    sender.get_compressor_ref().set_dictionary(dictionary);
+    if(dictionary != nullptr) receiver.get_decompressor_ref().add_dictionary(dictionary);
+
+    auto received_count = size_t(0);
+    auto received_bytes = size_t(0);
+    auto receive_thread = std::thread([&] {
+        auto peer_address = EZSock::SocketAddress_IPv4();
+        auto chunk = EZSock::Buffer(chunk_size);
+        auto size = ssize_t(0);
+        // an empty chunk marks the end.
+        while((size = receiver.receive(peer_address, chunk)) > 0){
+            received_count ++;
+            received_bytes += size_t(size);
+        }
+    });
+
+    auto chunk = EZSock::Buffer(chunk_size);
+    auto begin = std::chrono::steady_clock::now();
+    auto next_send = begin;
+    auto sent_bytes = size_t(0);
+
+    for(size_t i = 0; i < chunk_count; i ++){
+        auto offset = (i * chunk_size) % (data.get_buf_size() - chunk_size);
+        std::memcpy(chunk.get_buf_base(), data.get_buf_base() + offset, chunk_size);
+
+        while(std::chrono::steady_clock::now() < next_send) std::this_thread::yield();
+
+        auto size = sender.send(receiver_address, chunk, chunk_size);
+        if(size < 0) continue;
+        sent_bytes += size_t(size);
+        next_send += std::chrono::nanoseconds(int64_t(size * 8 * 1000 / link_rate_mbps));
+    }
+
+    auto stored_count = sender.get_compressor_ref().get_stored_count();
+    for(size_t i = 0; i < 3; i ++){
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        sender.send(receiver_address, chunk, 0);
+    }
+    receive_thread.join();
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << name << " : ratio " << double(sent_bytes) / double(chunk_size * chunk_count);
+    std::cout << ", stored " << stored_count << " / " << chunk_count;
+    std::cout << ", delivered " << 100.0 * received_count / chunk_count << "%";
+    std::cout << ", goodput " << received_bytes * 8 / elapsed / 1e6 << " Mbit/s over a " << link_rate_mbps << " Mbit/s link" << std::endl;
+}
+
+int main() {
+    auto logs = EZSock::Buffer(size_t(1) << 22);
+    auto random = EZSock::Buffer(size_t(1) << 22);
+    make_data(logs, false, 1);
+    make_data(random, true, 2);
+
+    // dictionary built from earlier samples of the same stream.
+    auto samples = EZSock::Buffer(size_t(1) << 15);
+    make_data(samples, false, 3);
+    auto dictionary = EZSock::CompressionDictionary(1, samples, samples.get_buf_size());
+
+    run("logs   store     ", logs, EZSock::CompressionCodec::STORE, nullptr);
+    run("random store     ", random, EZSock::CompressionCodec::STORE, nullptr);
+
+    if(EZSock::Compressor::is_available(EZSock::CompressionCodec::LZ4)){
+        run("logs   lz4       ", logs, EZSock::CompressionCodec::LZ4, nullptr);
+        run("logs   lz4 + dict", logs, EZSock::CompressionCodec::LZ4, &dictionary);
+        run("random lz4       ", random, EZSock::CompressionCodec::LZ4, nullptr);
+    }
+    else std::cout << "lz4 not built in (EZSOCK_WITH_LZ4)" << std::endl;
+
+    if(EZSock::Compressor::is_available(EZSock::CompressionCodec::ZSTD)){
+        run("logs   zstd      ", logs, EZSock::CompressionCodec::ZSTD, nullptr);
+        run("logs   zstd+dict ", logs, EZSock::CompressionCodec::ZSTD, &dictionary);
+        run("random zstd      ", random, EZSock::CompressionCodec::ZSTD, nullptr);
+    }
+    else std::cout << "zstd not built in (EZSOCK_WITH_ZSTD)" << std::endl;
+}
\ No newline at end of file
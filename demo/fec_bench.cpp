@@ -0,0 +1,64 @@
+#include "fec.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// to run payloads through encoder -> lossy link -> decoder, print throughput & goodput.
+static void run(EZSock::FECScheme scheme, uint8_t k, uint8_t m, double loss_rate) {
+    const auto payload_size = size_t(1400);
+    const auto payload_count = size_t(200000);
+
+    auto encoder = EZSock::FECEncoder(scheme, k, m, payload_size);
+    auto decoder = EZSock::FECDecoder();
+
+    auto payload = EZSock::Buffer(payload_size);
+    auto datagram = EZSock::Buffer(encoder.get_max_datagram_size());
+    auto received = EZSock::Buffer(payload_size);
+
+    for(size_t i = 0; i < payload_size; i ++) payload[i] = uint8_t(i * 7);
+
+    auto random_engine = std::mt19937_64(42);
+    auto loss_dist = std::bernoulli_distribution(loss_rate);
+
+    auto sent_bytes = size_t(0);
+    auto delivered_count = size_t(0);
+    auto encode_time = std::chrono::steady_clock::duration(0);
+    auto decode_time = std::chrono::steady_clock::duration(0);
+
+    for(size_t i = 0; i < payload_count; i ++){
+        auto begin = std::chrono::steady_clock::now();
+        encoder.push(payload, payload_size);
+        if(i + 1 == payload_count) encoder.flush();
+        encode_time += std::chrono::steady_clock::now() - begin;
+
+        auto size = ssize_t(0);
+        while((size = encoder.pop(datagram)) >= 0){
+            sent_bytes += size_t(size);
+            if(loss_dist(random_engine)) continue;
+
+            begin = std::chrono::steady_clock::now();
+            decoder.push(datagram, size_t(size));
+            while(decoder.pop(received) >= 0) delivered_count ++;
+            decode_time += std::chrono::steady_clock::now() - begin;
+        }
+    }
+
+    auto total_bytes = double(payload_size) * payload_count;
+    auto encode_gbps = total_bytes / std::chrono::duration<double>(encode_time).count() / 1e9;
+    auto decode_gbps = total_bytes / std::chrono::duration<double>(decode_time).count() / 1e9;
+
+    std::cout << (scheme == EZSock::FECScheme::XOR ? "xor" : "rs ") << " k=" << int(k) << " m=" << int(m) << " loss=" << loss_rate * 100 << "% : ";
+    std::cout << "encode " << encode_gbps << " GB/s, decode " << decode_gbps << " GB/s, ";
+    std::cout << "delivered " << 100.0 * delivered_count / payload_count << "%, ";
+    std::cout << "goodput " << 100.0 * delivered_count * payload_size / sent_bytes << "% of sent bytes" << std::endl;
+}
+
+int main() {
+    for(auto loss_rate : {0.0, 0.01, 0.05}){
+        run(EZSock::FECScheme::XOR, 16, 1, loss_rate);
+        run(EZSock::FECScheme::XOR, 16, 4, loss_rate);
+        run(EZSock::FECScheme::REED_SOLOMON, 16, 4, loss_rate);
+        run(EZSock::FECScheme::REED_SOLOMON, 32, 8, loss_rate);
+    }
+}
\ No newline at end of file
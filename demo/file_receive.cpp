@@ -1,7 +1,15 @@
 #include "udp_socket.hpp"
+#include "wire_format.hpp"
 #include <fstream>
 #include <iostream>
 
+// header in front of every chunk of file, -1 marks the end.
+struct FilePacket {
+    int32_t packet_count;
+};
+
+using FilePacketFormat = EZSock::WireFormat<EZSock::WireField<&FilePacket::packet_count>>;
+
 int main() {
     auto local_socket = EZSock::UDPSocket();
     auto local_address = EZSock::SocketAddress_IPv4(AUTO_IPV4_ADDRESS, 10750);
@@ -16,19 +24,19 @@ int main() {
         return 0;
     }
 
-    auto packet_count = int(0);
+    auto packet = FilePacket{0};
 
     while(true){
-        local_socket.receive(target_address);
-
-        packet_count = *(int *)local_socket.get_buf_ref_const().get_buf_base();
+        auto size = local_socket.receive(target_address);
+        if(size < 0 || FilePacketFormat::decode(local_socket.get_buf_ref_const(), size_t(size), packet) < 0) continue;
+        auto packet_count = packet.packet_count;
 
         std::cout << (std::string("Packet ") + std::to_string(packet_count) + " received.").c_str() << std::endl;
         std::cout << "Message from <" << target_address << ">:" << std::endl;
         std::cout << local_socket.get_buf_ref_const() << std::endl;
 
         if(packet_count != -1){
-            file_out.write((const char *)local_socket.get_buf_ref().get_buf_base() + 4, 508);
+            file_out.write((const char *)local_socket.get_buf_ref().get_buf_base() + FilePacketFormat::MAX_SIZE, 512 - FilePacketFormat::MAX_SIZE);
         }
 
         local_socket.get_buf_ref() = (std::string("Packet ") + std::to_string(packet_count) + " received.").c_str();
@@ -1,7 +1,15 @@
 #include "udp_socket.hpp"
+#include "wire_format.hpp"
 #include <fstream>
 #include <iostream>
 
+// header in front of every chunk of file, -1 marks the end.
+struct FilePacket {
+    int32_t packet_count;
+};
+
+using FilePacketFormat = EZSock::WireFormat<EZSock::WireField<&FilePacket::packet_count>>;
+
 int main() {
     auto local_socket = EZSock::UDPSocket();
     auto local_address = EZSock::SocketAddress_IPv4(AUTO_IPV4_ADDRESS, 8080);
@@ -16,22 +24,23 @@ int main() {
         return 0;
     }
 
-    auto packet_count = int(0);
+    auto packet = FilePacket{0};
 
     while(!file_in.eof()){
-        file_in.read((char *)local_socket.get_buf_ref().get_buf_base() + 4, 508);
+        file_in.read((char *)local_socket.get_buf_ref().get_buf_base() + FilePacketFormat::MAX_SIZE, 512 - FilePacketFormat::MAX_SIZE);
 
-        *(int *)&(local_socket.get_buf_ref()[0]) = packet_count;
+        FilePacketFormat::encode(packet, local_socket.get_buf_ref());
 
         local_socket.send(target_address);
         local_socket.receive();
 
         std::cout << "Message from <" << target_address << ">: " << local_socket.get_buf_ref_const().get_buf_base() << std::endl;
 
-        packet_count ++;
+        packet.packet_count ++;
     }
 
-    *(int *)&(local_socket.get_buf_ref()[0]) = -1;
+    packet.packet_count = -1;
+    FilePacketFormat::encode(packet, local_socket.get_buf_ref());
     local_socket.send(target_address);
     local_socket.receive();
 
@@ -0,0 +1,47 @@
+#include "udp_socket.hpp"
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+int main() {
+    const auto subscriber_count = size_t(1000);
+    const auto round_count = size_t(200);
+    const auto base_port = EZSock::IPv4_Port(20000);
+
+    auto loopback = EZSock::IPv4_Address::cstr_to_ipv4_address("127.0.0.1");
+
+    // subscribers only need to exist, datagrams beyond their queue are dropped by kernel.
+    auto subscribers = std::deque<EZSock::UDPSocket>();
+    auto targets = std::vector<EZSock::SocketAddress_IPv4>();
+    for(size_t i = 0; i < subscriber_count; i ++){
+        auto address = EZSock::SocketAddress_IPv4(loopback, EZSock::IPv4_Port(base_port + i));
+        subscribers.emplace_back(64);
+        if(subscribers.back().bind(address) < 0){
+            std::cout << "Bind " << address << " failed!" << std::endl;
+            return 0;
+        }
+        targets.push_back(address);
+    }
+
+    auto local_socket = EZSock::UDPSocket(256);
+    local_socket.bind(EZSock::SocketAddress_IPv4(loopback, EZSock::IPv4_Port(base_port - 1)));
+    local_socket.get_buf_ref() = "market data tick";
+
+    auto begin = std::chrono::steady_clock::now();
+    for(size_t round = 0; round < round_count; round ++){
+        for(const auto & target : targets) local_socket.send(target, local_socket.get_buf_ref_const(), 64);
+    }
+    auto loop_time = std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    for(size_t round = 0; round < round_count; round ++){
+        local_socket.send_to_all(targets, local_socket.get_buf_ref_const(), 64);
+    }
+    auto batch_time = std::chrono::steady_clock::now() - begin;
+
+    auto datagram_count = double(subscriber_count * round_count);
+    std::cout << "subscribers : " << subscriber_count << ", rounds : " << round_count << std::endl;
+    std::cout << "send loop   : " << std::chrono::duration<double, std::nano>(loop_time).count() / datagram_count << " ns/datagram" << std::endl;
+    std::cout << "send_to_all : " << std::chrono::duration<double, std::nano>(batch_time).count() / datagram_count << " ns/datagram" << std::endl;
+}
\ No newline at end of file
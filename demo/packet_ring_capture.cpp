@@ -0,0 +1,71 @@
+#include "packet_ring_receiver.hpp"
+#include "udp_socket.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// usage : packet_ring_capture [interface = lo] [threads = 1]
+int main(int argc, char ** argv) {
+    const auto * interface_name = argc > 1 ? argv[1] : "lo";
+    const auto thread_count = argc > 2 ? size_t(std::atoi(argv[2])) : size_t(1);
+    const auto datagram_count = size_t(200000);
+    const auto target_port = EZSock::IPv4_Port(10750);
+
+    // one ring per thread, kernel spreads flows over the fanout group.
+    auto receivers = std::vector<EZSock::PacketRingReceiver *>();
+    for(size_t i = 0; i < thread_count; i ++){
+        auto * receiver = new EZSock::PacketRingReceiver();
+        if(receiver->open(interface_name) < 0 || (thread_count > 1 && receiver->join_fanout(0x5a5a, EZSock::PacketFanoutMode::HASH) < 0)){
+            std::cout << "Packet ring on " << interface_name << " not open (needs CAP_NET_RAW)!" << std::endl;
+            return 0;
+        }
+        receivers.push_back(receiver);
+    }
+
+    auto captured_count = std::atomic<size_t>(0);
+    auto is_running = std::atomic<bool>(true);
+
+    auto threads = std::vector<std::thread>();
+    for(auto * receiver : receivers){
+        threads.emplace_back([&, receiver] {
+            while(is_running){
+                receiver->receive([&](const EZSock::UDPPacketView & view) {
+                    if(view.get_destination().get_ipv4_port() == target_port) captured_count ++;
+                }, 100);
+            }
+        });
+    }
+
+    // a few flows, so that hash fanout has something to spread.
+    auto loopback = EZSock::IPv4_Address::cstr_to_ipv4_address("127.0.0.1");
+    auto senders = std::vector<EZSock::UDPSocket *>();
+    for(size_t i = 0; i < 4; i ++){
+        auto * sender = new EZSock::UDPSocket(64);
+        sender->bind(EZSock::SocketAddress_IPv4(loopback, EZSock::IPv4_Port(10760 + i)));
+        sender->get_buf_ref() = "captured payload";
+        senders.push_back(sender);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < datagram_count; i ++){
+        senders[i % senders.size()]->send(EZSock::SocketAddress_IPv4(loopback, target_port));
+    }
+
+    // let rings retire their last blocks.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    is_running = false;
+    for(auto & thread : threads) thread.join();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    auto drop_count = int64_t(0);
+    for(auto * receiver : receivers) drop_count += receiver->get_drop_count();
+
+    std::cout << "sent " << datagram_count << ", captured " << captured_count << ", dropped by kernel " << drop_count << std::endl;
+    std::cout << "capture rate " << captured_count / elapsed << " pps over " << thread_count << " thread(s)" << std::endl;
+
+    for(auto * sender : senders) delete sender;
+    for(auto * receiver : receivers) delete receiver;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "packet_trace.hpp"
+#include "udp_socket.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// to record datagrams arriving on a port.
+static int record(const char * path, EZSock::IPv4_Port port, size_t count) {
+    auto socket = EZSock::UDPSocket(65536);
+    if(socket.bind(EZSock::SocketAddress_IPv4(AUTO_IPV4_ADDRESS, port)) < 0){
+        std::cout << "Port " << port << " not available!" << std::endl;
+        return 1;
+    }
+
+    auto recorder = EZSock::PacketTraceRecorder();
+    if(recorder.open(path) < 0){
+        std::cout << "Trace file not open!" << std::endl;
+        return 1;
+    }
+
+    auto source = EZSock::SocketAddress_IPv4();
+    for(size_t i = 0; i < count; i ++) recorder.receive(socket, source);
+
+    recorder.close();
+    std::cout << "recorded " << recorder.get_record_count() << ", dropped " << recorder.get_drop_count() << std::endl;
+    return 0;
+}
+
+// to replay a trace to a target.
+static int replay(const char * path, const EZSock::SocketAddress_IPv4 & target, double speed) {
+    auto reader = EZSock::PacketTraceReader();
+    if(reader.open(path) < 0){
+        std::cout << "Not a trace file!" << std::endl;
+        return 1;
+    }
+
+    auto socket = EZSock::UDPSocket(64);
+    socket.bind(EZSock::SocketAddress_IPv4());
+    auto replayer = EZSock::PacketTraceReplayer(socket);
+
+    auto begin = std::chrono::steady_clock::now();
+    auto sent = replayer.replay(reader, target, speed);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "sent " << sent << " in " << elapsed << " s (" << sent / elapsed << " pps), ";
+    std::cout << "lateness mean " << replayer.get_mean_lateness() << " ns, max " << replayer.get_max_lateness() << " ns" << std::endl;
+    return 0;
+}
+
+// to write a synthetic trace at a given rate, then replay it at original and full speed.
+static int bench() {
+    const auto * path = "/tmp/ezsock_trace_bench.bin";
+    const auto record_count = size_t(500000);
+    const auto interval_ns = uint64_t(5000);
+
+    // default chunks : when records arrive faster than disk drains them, the rest are dropped and counted.
+    auto recorder = EZSock::PacketTraceRecorder();
+    if(recorder.open(path) < 0){
+        std::cout << "Trace file not open!" << std::endl;
+        return 1;
+    }
+
+    uint8_t payload[128];
+    std::memset(payload, 0x5a, sizeof(payload));
+    auto source = EZSock::SocketAddress_IPv4(EZSock::IPv4_Address::cstr_to_ipv4_address("10.0.0.1"), 4000);
+    auto timestamp = EZSock::PacketTraceRecorder::get_now();
+
+    auto begin = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < record_count; i ++){
+        recorder.record(timestamp + i * interval_ns, source, payload, 64 + i % 64);
+    }
+    auto record_elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    recorder.close();
+
+    std::cout << "record : " << record_elapsed / record_count << " ns per datagram, dropped " << recorder.get_drop_count() << std::endl;
+
+    // every record counted must be in the file, dropped ones are not replayed.
+    auto reader = EZSock::PacketTraceReader();
+    auto record = EZSock::PacketTraceRecord();
+    auto stored_count = uint64_t(0);
+    if(reader.open(path) == 0){
+        while(reader.next(record)) stored_count ++;
+    }
+    std::cout << "stored : " << stored_count << " of " << recorder.get_record_count() << " recorded" << std::endl;
+    if(stored_count != recorder.get_record_count()){
+        std::cout << "Trace lost records on close!" << std::endl;
+        ::unlink(path);
+        return 1;
+    }
+
+    // nobody reads the sink, loopback drops what its queue cannot hold.
+    auto loopback = EZSock::IPv4_Address::cstr_to_ipv4_address("127.0.0.1");
+    auto sink = EZSock::UDPSocket(64);
+    sink.bind(EZSock::SocketAddress_IPv4(loopback, 10750));
+
+    std::cout << "replay at original rate (" << 1e9 / interval_ns << " pps) : ";
+    replay(path, sink.get_socket_address(), 1.0);
+    std::cout << "replay at full speed : ";
+    replay(path, sink.get_socket_address(), 0.0);
+
+    ::unlink(path);
+    return 0;
+}
+
+// usage :
+//     packet_trace_replay                                      run benchmark
+//     packet_trace_replay record <file> <port> <count>         record datagrams arriving on a port
+//     packet_trace_replay replay <file> <ip> <port> [speed]    replay a trace (speed 0 : as fast as possible)
+int main(int argc, char ** argv) {
+    if(argc >= 5 && std::strcmp(argv[1], "record") == 0){
+        return record(argv[2], EZSock::IPv4_Port(std::atoi(argv[3])), size_t(std::atol(argv[4])));
+    }
+    if(argc >= 5 && std::strcmp(argv[1], "replay") == 0){
+        auto target = EZSock::SocketAddress_IPv4(EZSock::IPv4_Address::cstr_to_ipv4_address(argv[3]), EZSock::IPv4_Port(std::atoi(argv[4])));
+        return replay(argv[2], target, argc > 5 ? std::atof(argv[5]) : 1.0);
+    }
+
+    return bench();
+}
\ No newline at end of file
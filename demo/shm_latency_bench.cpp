@@ -0,0 +1,61 @@
+#include "shared_memory_socket.hpp"
+#include "udp_socket.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static const auto round_trip_count = size_t(100000);
+
+// to bounce datagrams between two sockets, print median & p99.9 of one way latency (RTT / 2).
+template<typename Socket>
+static void ping_pong(const char * name, Socket & client, Socket & server, const typename Socket::Address & client_address, const typename Socket::Address & server_address) {
+    auto echo_thread = std::thread([&] {
+        auto peer_address = typename Socket::Address();
+        for(size_t i = 0; i < round_trip_count; i ++){
+            auto size = server.receive(peer_address);
+            while(server.send(client_address, server.get_buf_ref_const(), size_t(size)) < 0) std::this_thread::yield();
+        }
+    });
+
+    auto samples = std::vector<double>(round_trip_count);
+    auto peer_address = typename Socket::Address();
+    for(size_t i = 0; i < round_trip_count; i ++){
+        auto begin = std::chrono::steady_clock::now();
+        client.send(server_address, client.get_buf_ref_const(), 64);
+        client.receive(peer_address);
+        samples[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / 2;
+    }
+
+    echo_thread.join();
+
+    std::sort(samples.begin(), samples.end());
+    std::cout << name << " : median " << samples[samples.size() / 2] << " ns, p99.9 " << samples[samples.size() * 999 / 1000] << " ns" << std::endl;
+}
+
+// to run ping pong over a shared memory channel with given wait mode.
+static void run_shared_memory(const char * name, EZSock::SharedMemoryWaitMode wait_mode) {
+    auto client = EZSock::SharedMemorySocket(64, wait_mode);
+    auto server = EZSock::SharedMemorySocket(64, wait_mode);
+    client.create(1024);
+    server.attach(client.get_shm_fd());
+
+    ping_pong(name, client, server, server.get_peer_address(), client.get_peer_address());
+}
+
+int main() {
+    run_shared_memory("shm futex    ", EZSock::SharedMemoryWaitMode::FUTEX);
+    // both sides spin, so busy polling needs a cpu for each.
+    if(std::thread::hardware_concurrency() > 1) run_shared_memory("shm busy-poll", EZSock::SharedMemoryWaitMode::BUSY_POLL);
+
+    auto loopback = EZSock::IPv4_Address::cstr_to_ipv4_address("127.0.0.1");
+    auto client_address = EZSock::SocketAddress_IPv4(loopback, 10751);
+    auto server_address = EZSock::SocketAddress_IPv4(loopback, 10750);
+    auto client = EZSock::UDPSocket(64);
+    auto server = EZSock::UDPSocket(64);
+    client.bind(client_address);
+    server.bind(server_address);
+
+    ping_pong("udp loopback ", client, server, client_address, server_address);
+}
\ No newline at end of file
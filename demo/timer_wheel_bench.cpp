@@ -0,0 +1,77 @@
+#include "timer_wheel.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// to measure nanoseconds per operation of a function.
+template<typename F>
+static double measure(size_t count, F && f) {
+    auto begin = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - begin).count() / count;
+}
+
+// to check timers whose deadline crosses a wrap of the top level (2^32 ticks) still fire on time.
+static bool check_wrap() {
+    auto timer_wheel = EZSock::TimerWheel();
+    auto wrap_tick = uint64_t(1) << 32;
+    timer_wheel.expire(wrap_tick - 10);
+
+    auto fired_tick = uint64_t(0);
+    timer_wheel.add_timer(20, [&] { fired_tick = timer_wheel.get_current_tick(); });
+    // more than one wrap away, parked until the top level wraps.
+    timer_wheel.add_timer(wrap_tick + 1000, [] {});
+
+    timer_wheel.expire(wrap_tick + 9);
+    if(fired_tick != 0) return false;
+    timer_wheel.expire(wrap_tick + 10);
+    if(fired_tick != wrap_tick + 10 || timer_wheel.get_timer_count() != 1) return false;
+
+    if(timer_wheel.expire(wrap_tick * 2 + 989) != 0) return false;
+    return timer_wheel.expire(wrap_tick * 2 + 990) == 1 && timer_wheel.get_timer_count() == 0;
+}
+
+int main() {
+    if(!check_wrap()){
+        std::cout << "Timer across 2^32 ticks did not fire on time!" << std::endl;
+        return 1;
+    }
+
+    const auto timer_count = size_t(1000000);
+
+    auto timer_wheel = EZSock::TimerWheel();
+    auto handles = std::vector<EZSock::TimerHandle>(timer_count);
+
+    // delays spread over ~1 minute of 1 ms ticks, like retransmission & idle timers.
+    auto random_engine = std::mt19937_64(42);
+    auto delay_dist = std::uniform_int_distribution<uint64_t>(1, 60000);
+    auto delays = std::vector<uint64_t>(timer_count);
+    for(auto & delay : delays) delay = delay_dist(random_engine);
+
+    auto fired_count = size_t(0);
+
+    auto insert_ns = measure(timer_count, [&] {
+        for(size_t i = 0; i < timer_count; i ++){
+            handles[i] = timer_wheel.add_timer(delays[i], [&fired_count] { fired_count ++; });
+        }
+    });
+
+    auto cancel_ns = measure(timer_count / 2, [&] {
+        for(size_t i = 0; i < timer_count; i += 2){
+            timer_wheel.cancel_timer(handles[i]);
+        }
+    });
+
+    auto expired_count = size_t(0);
+    auto expire_ns = measure(timer_count / 2, [&] {
+        expired_count = timer_wheel.expire(timer_wheel.get_current_tick() + 60000);
+    });
+
+    std::cout << "timers : " << timer_count << std::endl;
+    std::cout << "insert : " << insert_ns << " ns/op" << std::endl;
+    std::cout << "cancel : " << cancel_ns << " ns/op" << std::endl;
+    std::cout << "expire : " << expire_ns << " ns/op (" << expired_count << " fired, " << fired_count << " callbacks)" << std::endl;
+}
\ No newline at end of file
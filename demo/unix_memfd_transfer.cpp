@@ -0,0 +1,61 @@
+#include "unix_datagram_socket.hpp"
+#include "udp_socket.hpp"
+#include <sys/mman.h>
+#include <cstring>
+#include <iostream>
+
+// same echo round trip over any transport sharing the UDPSocket interface.
+template<typename Socket>
+static void echo(Socket & client, Socket & server, const typename Socket::Address & server_address) {
+    auto client_address = typename Socket::Address();
+    auto peer_address = typename Socket::Address();
+
+    client.get_buf_ref() = "ping";
+    client.send(server_address, client.get_buf_ref_const(), 5);
+
+    server.receive(peer_address);
+    std::cout << "Message from <" << peer_address << ">: " << server.get_buf_ref_const().get_buf_base() << std::endl;
+
+    server.get_buf_ref() = "pong";
+    server.send(peer_address, server.get_buf_ref_const(), 5);
+
+    client.receive(client_address);
+    std::cout << "Message from <" << client_address << ">: " << client.get_buf_ref_const().get_buf_base() << std::endl;
+}
+
+int main() {
+    auto loopback = EZSock::IPv4_Address::cstr_to_ipv4_address("127.0.0.1");
+    auto udp_client = EZSock::UDPSocket();
+    auto udp_server = EZSock::UDPSocket();
+    udp_client.bind(EZSock::SocketAddress_IPv4(loopback, 10751));
+    udp_server.bind(EZSock::SocketAddress_IPv4(loopback, 10750));
+    echo(udp_client, udp_server, EZSock::SocketAddress_IPv4(loopback, 10750));
+
+    auto unix_client = EZSock::UnixDatagramSocket();
+    auto unix_server = EZSock::UnixDatagramSocket();
+    unix_client.bind(EZSock::SocketAddress_Unix("@ezsock-demo-client"));
+    unix_server.bind(EZSock::SocketAddress_Unix("@ezsock-demo-server"));
+    echo(unix_client, unix_server, EZSock::SocketAddress_Unix("@ezsock-demo-server"));
+
+    // large payload : write once into a memfd, pass only the descriptor.
+    const auto payload_size = size_t(64) << 20;
+
+    auto fd = EZSock::UnixDatagramSocket::create_memfd("ezsock-payload", payload_size);
+    auto * payload = (uint8_t *)mmap(nullptr, payload_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    std::memset(payload, 0x5a, payload_size);
+    munmap(payload, payload_size);
+
+    *(uint64_t *)unix_client.get_buf_ref().get_buf_base() = payload_size;
+    unix_client.send_fd(EZSock::SocketAddress_Unix("@ezsock-demo-server"), fd, unix_client.get_buf_ref_const(), sizeof(uint64_t));
+    close(fd);
+
+    auto peer_address = EZSock::SocketAddress_Unix();
+    auto received_fd = int(-1);
+    unix_server.receive_fd(peer_address, received_fd);
+
+    auto received_size = *(const uint64_t *)unix_server.get_buf_ref_const().get_buf_base();
+    const auto * received = (const uint8_t *)mmap(nullptr, received_size, PROT_READ, MAP_SHARED, received_fd, 0);
+    std::cout << "Payload of " << received_size << " bytes from <" << peer_address << ">, last byte " << int(received[received_size - 1]) << std::endl;
+    munmap((void *)received, received_size);
+    close(received_fd);
+}
\ No newline at end of file
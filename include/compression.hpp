@@ -0,0 +1,332 @@
+/*
+ * @file compression.hpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-27
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#ifndef __COMPRESSION_HPP__
+#define __COMPRESSION_HPP__
+
+#include <cstdint>
+#include <map>
+
+#include "buffer.hpp"
+#include "socket_address.hpp"
+
+/* -------------------------------------------------------------------------------- */
+
+// build options :
+//     EZSOCK_WITH_LZ4     to enable LZ4 (link with -llz4).
+//     EZSOCK_WITH_ZSTD    to enable zstd (link with -lzstd).
+// a codec that is not built in is replaced by STORE on compression and rejected on decompression.
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // max size of header prepended to every compressed chunk.
+    // codec (1), dictionary id (varint, 0 : none), original size (varint).
+    #define COMPRESSION_HEADER_MAX_SIZE size_t(11)
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * enum class CompressionCodec
+     *
+     * to specify how a chunk is compressed.
+     * STORE : as is, LZ4 : fast, ZSTD : better ratio.
+     */
+    enum class CompressionCodec : uint8_t {
+        STORE   = 0,
+        LZ4     = 1,
+        ZSTD    = 2,
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // defined below
+    class Compressor;
+    class Decompressor;
+    // defined in udp_socket.hpp.
+    class UDPSocket;
+
+    /*
+     * class CompressionDictionary
+     *
+     * content shared by both ends of a stream, small chunks compress against it.
+     * raw samples work for both codecs, a zstd trained dictionary works best for ZSTD.
+     * codec state is prepared once here, so using a dictionary costs nothing per chunk.
+     * must outlive compressors & decompressors using it.
+     */
+    class CompressionDictionary {
+    private:
+        uint32_t id;
+        Buffer content;
+        // LZ4_stream_t with content loaded, copied before every chunk.
+        void * lz4_stream;
+        // ZSTD_CDict & ZSTD_DDict.
+        void * zstd_cdict;
+        void * zstd_ddict;
+
+    private:
+        friend EZSock::Compressor;
+        friend EZSock::Decompressor;
+
+    public:
+        // to initialize with id (not 0), first n bytes of a buffer as content and zstd level.
+        CompressionDictionary(uint32_t, const Buffer &, size_t, int = 3);
+        ~CompressionDictionary();
+
+        // explicitly ban copy and move ctors, codec state points into content.
+        CompressionDictionary(const CompressionDictionary &) = delete;
+        CompressionDictionary(CompressionDictionary &&) = delete;
+        CompressionDictionary & operator=(const CompressionDictionary &) = delete;
+        CompressionDictionary & operator=(CompressionDictionary &&) = delete;
+
+        // to get id.
+        inline uint32_t get_id() const noexcept;
+        // to get content.
+        inline const Buffer & get_content_ref_const() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class Compressor
+     *
+     * compressor of one stream, turns chunks into self describing frames.
+     * a chunk is stored as is when compression saves less than 1/16 of it,
+     * and after every such chunk the next few are stored without trying (doubling up to 64),
+     * so random data costs little more than a copy.
+     */
+    class Compressor {
+    private:
+        CompressionCodec codec;
+        int level;
+        const CompressionDictionary * dictionary;
+        // LZ4_stream_t & ZSTD_CCtx.
+        void * lz4_stream;
+        void * zstd_cctx;
+
+        uint32_t skip_count;
+        uint32_t skip_backoff;
+
+        uint64_t input_size;
+        uint64_t output_size;
+        uint64_t stored_count;
+        uint64_t compressed_count;
+
+    private:
+        // to compress into dst, at most n bytes. return size written, 0 if it does not fit.
+        size_t compress_payload(const uint8_t *, size_t, uint8_t *, size_t);
+
+    public:
+        // to initialize with codec and level (LZ4 : acceleration, ZSTD : level, 0 : default).
+        Compressor(CompressionCodec = CompressionCodec::LZ4, int = 0);
+        ~Compressor();
+
+        // explicitly ban copy and move ctors, codec state is owned.
+        Compressor(const Compressor &) = delete;
+        Compressor(Compressor &&) = delete;
+        Compressor & operator=(const Compressor &) = delete;
+        Compressor & operator=(Compressor &&) = delete;
+
+        // to check whether a codec is built in.
+        static bool is_available(CompressionCodec) noexcept;
+        // to get max size of frame of a chunk.
+        static inline size_t get_max_frame_size(size_t) noexcept;
+
+        // to set dictionary of stream (nullptr : none).
+        inline void set_dictionary(const CompressionDictionary *) noexcept;
+
+        // to compress n bytes into a frame. return size of frame, or -1 if dst is too small.
+        ssize_t compress(const uint8_t *, size_t, uint8_t *, size_t);
+        // to compress first n bytes of a buffer into a frame at the beginning of another buffer.
+        inline ssize_t compress(const Buffer &, size_t, Buffer &);
+
+        // to get total size of chunks.
+        inline uint64_t get_input_size() const noexcept;
+        // to get total size of frames.
+        inline uint64_t get_output_size() const noexcept;
+        // to get number of chunks stored as is.
+        inline uint64_t get_stored_count() const noexcept;
+        // to get number of chunks compressed.
+        inline uint64_t get_compressed_count() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class Decompressor
+     *
+     * decompressor of frames from any number of streams, dictionaries are looked up by id.
+     */
+    class Decompressor {
+    private:
+        std::map<uint32_t, const CompressionDictionary *> dictionaries;
+        // ZSTD_DCtx.
+        void * zstd_dctx;
+
+    public:
+        Decompressor();
+        ~Decompressor();
+
+        // explicitly ban copy and move ctors, codec state is owned.
+        Decompressor(const Decompressor &) = delete;
+        Decompressor(Decompressor &&) = delete;
+        Decompressor & operator=(const Decompressor &) = delete;
+        Decompressor & operator=(Decompressor &&) = delete;
+
+        // to register a dictionary under its id.
+        inline void add_dictionary(const CompressionDictionary *);
+        // to unregister a dictionary.
+        inline void remove_dictionary(uint32_t);
+
+        // to decompress a frame of n bytes. return size of chunk, or -1 if malformed / dst is too small.
+        ssize_t decompress(const uint8_t *, size_t, uint8_t *, size_t);
+        // to decompress a frame in first n bytes of a buffer into another buffer.
+        inline ssize_t decompress(const Buffer &, size_t, Buffer &);
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class CompressedSender
+     *
+     * Compressor bound to a UDPSocket, one frame per datagram.
+     */
+    class CompressedSender {
+    private:
+        UDPSocket & socket;
+        Compressor compressor;
+        Buffer datagram;
+
+    public:
+        // to initialize with socket, codec, max size of a chunk and level.
+        CompressedSender(UDPSocket &, CompressionCodec, size_t, int = 0);
+
+        // to send first n bytes of a buffer as one frame. return size of frame.
+        ssize_t send(const SocketAddress_IPv4 &, const Buffer &, size_t);
+
+        // to get compressor, e.g. to set dictionary.
+        inline Compressor & get_compressor_ref() noexcept;
+    };
+
+    /*
+     * class CompressedReceiver
+     *
+     * Decompressor bound to a UDPSocket.
+     * buffer of socket must hold the largest frame of sender.
+     */
+    class CompressedReceiver {
+    private:
+        UDPSocket & socket;
+        Decompressor decompressor;
+
+    public:
+        // to initialize with socket.
+        CompressedReceiver(UDPSocket &);
+
+        // to receive next chunk into buffer. malformed frames are dropped. return size of chunk.
+        ssize_t receive(SocketAddress_IPv4 &, Buffer &);
+
+        // to get decompressor, e.g. to add dictionaries.
+        inline Decompressor & get_decompressor_ref() noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // implements of inline functions.
+
+/* -------------------------------------------------------------------------------- */
+
+    // CompressionDictionary
+
+    inline uint32_t CompressionDictionary::get_id() const noexcept {
+        return id;
+    }
+
+    inline const Buffer & CompressionDictionary::get_content_ref_const() const noexcept {
+        return content;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // Compressor
+
+    // frames never grow beyond a stored chunk.
+    inline size_t Compressor::get_max_frame_size(size_t size) noexcept {
+        return COMPRESSION_HEADER_MAX_SIZE + size;
+    }
+
+    inline void Compressor::set_dictionary(const CompressionDictionary * src_dictionary) noexcept {
+        dictionary = src_dictionary;
+    }
+
+    inline ssize_t Compressor::compress(const Buffer & src_buf, size_t size, Buffer & dst_buf) {
+        if(size > src_buf.get_buf_size()) return -1;
+        return compress(src_buf.get_buf_base(), size, dst_buf.get_buf_base(), dst_buf.get_buf_size());
+    }
+
+    inline uint64_t Compressor::get_input_size() const noexcept {
+        return input_size;
+    }
+
+    inline uint64_t Compressor::get_output_size() const noexcept {
+        return output_size;
+    }
+
+    inline uint64_t Compressor::get_stored_count() const noexcept {
+        return stored_count;
+    }
+
+    inline uint64_t Compressor::get_compressed_count() const noexcept {
+        return compressed_count;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // Decompressor
+
+    inline void Decompressor::add_dictionary(const CompressionDictionary * dictionary) {
+        dictionaries[dictionary->get_id()] = dictionary;
+    }
+
+    inline void Decompressor::remove_dictionary(uint32_t id) {
+        dictionaries.erase(id);
+    }
+
+    inline ssize_t Decompressor::decompress(const Buffer & src_buf, size_t size, Buffer & dst_buf) {
+        if(size > src_buf.get_buf_size()) return -1;
+        return decompress(src_buf.get_buf_base(), size, dst_buf.get_buf_base(), dst_buf.get_buf_size());
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // CompressedSender
+
+    inline Compressor & CompressedSender::get_compressor_ref() noexcept {
+        return compressor;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // CompressedReceiver
+
+    inline Decompressor & CompressedReceiver::get_decompressor_ref() noexcept {
+        return decompressor;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
+
+#endif
\ No newline at end of file
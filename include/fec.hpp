@@ -0,0 +1,263 @@
+/*
+ * @file fec.hpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-12
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#ifndef __FEC_HPP__
+#define __FEC_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "buffer.hpp"
+#include "socket_address.hpp"
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // size of header prepended to every FEC datagram.
+    // scheme | parity flag (1), k (1), m (1), index (1), block id (4, network order).
+    #define FEC_HEADER_SIZE size_t(8)
+    // size of payload length stored in front of every shard.
+    #define FEC_LENGTH_SIZE size_t(2)
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * enum class FECScheme
+     *
+     * to specify how parity datagrams are computed.
+     * XOR : parity j covers data i with i % m == j, repairs one loss per group.
+     * REED_SOLOMON : systematic cauchy code over GF(2^8), repairs any m losses per block.
+     */
+    enum class FECScheme : uint8_t {
+        XOR             = 1,
+        REED_SOLOMON    = 2,
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class ReedSolomonCodec
+     *
+     * systematic reed-solomon over GF(2^8) (polynomial 0x11d) with a cauchy matrix.
+     * coefficients of a data column do not depend on k, so a block may be shortened freely.
+     * region multiply uses pshufb when the cpu has SSSE3 / AVX2 (checked at run time), table lookup otherwise.
+     */
+    class ReedSolomonCodec {
+    private:
+        uint8_t k;
+        uint8_t m;
+
+    public:
+        // to initialize with number of data & parity shards (k + m <= 256).
+        inline ReedSolomonCodec(uint8_t, uint8_t) noexcept;
+
+        // to compute m parity shards of given length from k data shards.
+        void encode(const uint8_t * const *, uint8_t * const *, size_t) const noexcept;
+        // to rebuild missing data shards in place.
+        // parameters : k data shards, m parity shards, presence flags (k + m), length of shard.
+        // return false if less than k shards are present.
+        bool reconstruct(uint8_t * const *, const uint8_t * const *, const bool *, size_t) const;
+
+        // to compute dst ^= c * src over GF(2^8).
+        static void mul_add_region(uint8_t *, const uint8_t *, uint8_t, size_t) noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class FECEncoder
+     *
+     * to group k payloads into a block and append m parity datagrams after it.
+     * datagrams ready to be sent are queued and fetched by pop().
+     */
+    class FECEncoder {
+    private:
+        FECScheme scheme;
+        uint8_t k;
+        uint8_t m;
+        size_t max_payload_size;
+
+        uint32_t block_id;
+        uint8_t data_count;
+        size_t shard_size;
+        std::vector<std::vector<uint8_t>> shards;
+
+        std::deque<std::vector<uint8_t>> datagrams;
+
+    private:
+        // to compute parity of current block and start a new one.
+        void finish_block();
+
+    public:
+        // to initialize with scheme, k, m and max size of a payload.
+        FECEncoder(FECScheme, uint8_t, uint8_t, size_t);
+
+        // to add a payload. return -1 if it is too large.
+        ssize_t push(const uint8_t *, size_t);
+        // to add first n bytes of a buffer as payload.
+        inline ssize_t push(const Buffer &, size_t);
+        // to close a partial block, emitting its parity now.
+        void flush();
+
+        // to copy next datagram into buffer. return its size, or -1 if none queued.
+        ssize_t pop(Buffer &);
+
+        // to get max size of a datagram produced.
+        inline size_t get_max_datagram_size() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class FECDecoder
+     *
+     * to collect datagrams of FECEncoder and hand out payloads.
+     * data datagrams are handed out at once, missing ones as soon as their block can be repaired.
+     * order of payloads is not preserved.
+     * block ids may wrap, a block id far behind the window means the sender restarted and the window starts over.
+     */
+    class FECDecoder {
+    private:
+        struct FECBlock {
+            FECScheme scheme;
+            uint8_t k;
+            uint8_t m;
+            // k carried by data datagrams (0 : none seen yet), parity of a partial block carries less.
+            uint8_t data_k;
+            size_t shard_size;
+            size_t present_count;
+            bool is_done;
+            std::vector<std::vector<uint8_t>> shards;
+            std::vector<bool> is_present;
+            std::vector<bool> is_delivered;
+        };
+
+        size_t window;
+        std::map<uint32_t, FECBlock> blocks;
+        // newest block id seen, ids are compared as serial numbers (wrapping at 2^32).
+        uint32_t newest_block_id;
+
+        std::deque<std::vector<uint8_t>> payloads;
+
+    private:
+        void deliver(FECBlock &, uint8_t);
+        void repair(FECBlock &);
+        void try_repair(FECBlock &);
+
+    public:
+        // to initialize with number of blocks kept for repair.
+        FECDecoder(size_t = 64);
+
+        // to feed a received datagram. return -1 if it is not a FEC datagram or does not match its block.
+        ssize_t push(const uint8_t *, size_t);
+        // to feed first n bytes of a buffer as received datagram.
+        inline ssize_t push(const Buffer &, size_t);
+
+        // to copy next payload into buffer. return its size, or -1 if none ready.
+        ssize_t pop(Buffer &);
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // defined in udp_socket.hpp.
+    class UDPSocket;
+
+    /*
+     * class FECSender
+     *
+     * FECEncoder bound to a UDPSocket.
+     */
+    class FECSender {
+    private:
+        UDPSocket & socket;
+        FECEncoder encoder;
+        Buffer datagram;
+
+    private:
+        ssize_t send_queued(const SocketAddress_IPv4 &);
+
+    public:
+        // to initialize with socket, scheme, k, m and max size of a payload.
+        FECSender(UDPSocket &, FECScheme, uint8_t, uint8_t, size_t);
+
+        // to send first n bytes of a buffer, followed by parity when a block is full.
+        ssize_t send(const SocketAddress_IPv4 &, const Buffer &, size_t);
+        // to send parity of a partial block.
+        ssize_t flush(const SocketAddress_IPv4 &);
+    };
+
+    /*
+     * class FECReceiver
+     *
+     * FECDecoder bound to a UDPSocket, one per sender.
+     * buffer of socket must hold the largest datagram of sender.
+     */
+    class FECReceiver {
+    private:
+        UDPSocket & socket;
+        size_t window;
+        // one decoder per source (ip, port), block ids of different senders collide.
+        std::map<std::pair<IPv4_Address_t, IPv4_Port_t>, FECDecoder> decoders;
+        // decoder fed last, may still hold payloads, and its source.
+        FECDecoder * last_decoder;
+        SocketAddress_IPv4 last_source;
+
+    public:
+        // to initialize with socket and number of blocks kept for repair.
+        FECReceiver(UDPSocket &, size_t = 64);
+
+        // to receive next payload (received or repaired) into buffer. return its size.
+        ssize_t receive(SocketAddress_IPv4 &, Buffer &);
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // implements of inline functions.
+
+/* -------------------------------------------------------------------------------- */
+
+    // ReedSolomonCodec
+
+    inline ReedSolomonCodec::ReedSolomonCodec(uint8_t src_k, uint8_t src_m) noexcept : k(src_k), m(src_m) {}
+
+/* -------------------------------------------------------------------------------- */
+
+    // FECEncoder
+
+    inline ssize_t FECEncoder::push(const Buffer & src_buf, size_t size) {
+        if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+        return push(src_buf.get_buf_base(), size);
+    }
+
+    inline size_t FECEncoder::get_max_datagram_size() const noexcept {
+        return FEC_HEADER_SIZE + FEC_LENGTH_SIZE + max_payload_size;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // FECDecoder
+
+    inline ssize_t FECDecoder::push(const Buffer & src_buf, size_t size) {
+        if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+        return push(src_buf.get_buf_base(), size);
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
+
+#endif
\ No newline at end of file
@@ -0,0 +1,240 @@
+/*
+ * @file packet_ring_receiver.hpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-22
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#ifndef __PACKET_RING_RECEIVER_HPP__
+#define __PACKET_RING_RECEIVER_HPP__
+
+#include <linux/if_packet.h>
+#include <cstdint>
+#include <iosfwd>
+
+#include "socket_address.hpp"
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * enum class PacketFanoutMode
+     *
+     * to specify how packets are spread over receivers sharing a fanout group.
+     */
+    enum class PacketFanoutMode : uint16_t {
+        HASH            = PACKET_FANOUT_HASH,
+        LOAD_BALANCE    = PACKET_FANOUT_LB,
+        CPU             = PACKET_FANOUT_CPU,
+        ROLLOVER        = PACKET_FANOUT_ROLLOVER,
+        QUEUE_MAPPING   = PACKET_FANOUT_QM,
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // defined below
+    class PacketRingReceiver;
+
+    /*
+     * class UDPPacketView
+     *
+     * a UDP datagram seen in the packet ring, parsed in place.
+     * payload points into the ring and is valid only inside the handler it is passed to.
+     */
+    class UDPPacketView {
+    private:
+        SocketAddress_IPv4 source;
+        SocketAddress_IPv4 destination;
+        const uint8_t * payload;
+        size_t payload_size;
+        uint32_t timestamp_sec;
+        uint32_t timestamp_nsec;
+
+    private:
+        friend EZSock::PacketRingReceiver;
+
+        inline UDPPacketView() noexcept;
+
+    public:
+        UDPPacketView(const UDPPacketView &) = default;
+        UDPPacketView(UDPPacketView &&) = default;
+        ~UDPPacketView() = default;
+        UDPPacketView & operator=(const UDPPacketView &) = default;
+        UDPPacketView & operator=(UDPPacketView &&) = default;
+
+        // to get source ip & port.
+        inline const SocketAddress_IPv4 & get_source() const noexcept;
+        // to get destination ip & port.
+        inline const SocketAddress_IPv4 & get_destination() const noexcept;
+        // to get base address of payload.
+        inline const uint8_t * get_payload() const noexcept;
+        // to get size of payload captured (may be less than datagram if snapped).
+        inline size_t get_payload_size() const noexcept;
+        // to get kernel receive timestamp, seconds part.
+        inline uint32_t get_timestamp_sec() const noexcept;
+        // to get kernel receive timestamp, nanoseconds part.
+        inline uint32_t get_timestamp_nsec() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class PacketRingReceiver
+     *
+     * receiver of all IPv4 / UDP traffic on an interface through an AF_PACKET TPACKET_V3 ring.
+     * the kernel fills memory mapped blocks, a whole block is parsed per wake up and then returned.
+     * several receivers (one per thread) may share load through a fanout group.
+     * needs CAP_NET_RAW.
+     */
+    class PacketRingReceiver {
+    private:
+        int socket;
+        uint8_t * ring_base;
+        size_t block_size;
+        size_t block_count;
+        size_t block_index;
+        uint32_t retire_timeout;
+
+        bool is_active;
+        bool is_outgoing_included;
+
+    private:
+        // to wait for next block, return its descriptor or nullptr on timeout / error.
+        tpacket_block_desc * next_block(int);
+        // to hand a block back to kernel.
+        void release_block(tpacket_block_desc *) noexcept;
+        // to parse a frame as IPv4 / UDP. return false if it is anything else.
+        bool parse(const tpacket3_hdr *, UDPPacketView &) const noexcept;
+
+    public:
+        // to initialize with size of a block, number of blocks and block retire timeout in ms.
+        inline PacketRingReceiver(size_t = size_t(1) << 20, size_t = 32, uint32_t = 10);
+        inline ~PacketRingReceiver();
+
+        // explicitly ban copy and move ctors, ring memory is owned.
+        PacketRingReceiver(const PacketRingReceiver &) = delete;
+        PacketRingReceiver(PacketRingReceiver &&) = delete;
+        PacketRingReceiver & operator=(const PacketRingReceiver &) = delete;
+        PacketRingReceiver & operator=(PacketRingReceiver &&) = delete;
+
+        // to open ring on an interface (e.g. "lo", "eth0").
+        int open(const char *);
+        // to join a fanout group, must be called after open().
+        int join_fanout(uint16_t, PacketFanoutMode = PacketFanoutMode::HASH);
+        // to unmap ring and close socket.
+        int close();
+
+        // to set whether packets sent by this host are seen too (off by default).
+        // on loopback every datagram is seen twice when on.
+        inline void set_outgoing_included(bool) noexcept;
+
+        // to call handler with every UDP datagram of next block. wait at most timeout ms (-1 : forever).
+        // return number of datagrams handled, or -1 on error.
+        template<typename Handler>
+        ssize_t receive(Handler &&, int = -1);
+
+        // to get number of packets dropped by kernel since last call.
+        int64_t get_drop_count() const;
+
+        // to get socket.
+        inline int get_socket() const noexcept;
+        // to get status (true : active, false : closed).
+        inline bool get_status() const noexcept;
+
+        // to print as "<socket> - PACKET ring <block count> * <block size> , <is_active>"
+        friend std::ostream & operator<<(std::ostream &, const PacketRingReceiver &);
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // implements of inline functions.
+
+/* -------------------------------------------------------------------------------- */
+
+    // UDPPacketView
+
+    inline UDPPacketView::UDPPacketView() noexcept : source(), destination(), payload(nullptr), payload_size(0), timestamp_sec(0), timestamp_nsec(0) {}
+
+    inline const SocketAddress_IPv4 & UDPPacketView::get_source() const noexcept {
+        return source;
+    }
+
+    inline const SocketAddress_IPv4 & UDPPacketView::get_destination() const noexcept {
+        return destination;
+    }
+
+    inline const uint8_t * UDPPacketView::get_payload() const noexcept {
+        return payload;
+    }
+
+    inline size_t UDPPacketView::get_payload_size() const noexcept {
+        return payload_size;
+    }
+
+    inline uint32_t UDPPacketView::get_timestamp_sec() const noexcept {
+        return timestamp_sec;
+    }
+
+    inline uint32_t UDPPacketView::get_timestamp_nsec() const noexcept {
+        return timestamp_nsec;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketRingReceiver
+
+    inline PacketRingReceiver::PacketRingReceiver(size_t src_block_size, size_t src_block_count, uint32_t src_retire_timeout) : socket(-1), ring_base(nullptr), block_size(src_block_size), block_count(src_block_count), block_index(0), retire_timeout(src_retire_timeout), is_active(false), is_outgoing_included(false) {}
+
+    inline PacketRingReceiver::~PacketRingReceiver() {
+        if(is_active) close();
+    }
+
+    inline void PacketRingReceiver::set_outgoing_included(bool is_included) noexcept {
+        is_outgoing_included = is_included;
+    }
+
+    template<typename Handler>
+    ssize_t PacketRingReceiver::receive(Handler && handler, int timeout) {
+        if(!is_active) return -1;
+
+        auto * block = next_block(timeout);
+        if(block == nullptr) return 0;
+
+        auto handled = ssize_t(0);
+        auto view = UDPPacketView();
+
+        const auto * frame = (const tpacket3_hdr *)((const uint8_t *)block + block->hdr.bh1.offset_to_first_pkt);
+        for(uint32_t i = 0; i < block->hdr.bh1.num_pkts; i ++){
+            if(parse(frame, view)){
+                handler(static_cast<const UDPPacketView &>(view));
+                handled ++;
+            }
+            frame = (const tpacket3_hdr *)((const uint8_t *)frame + frame->tp_next_offset);
+        }
+
+        release_block(block);
+
+        return handled;
+    }
+
+    inline int PacketRingReceiver::get_socket() const noexcept {
+        return socket;
+    }
+
+    inline bool PacketRingReceiver::get_status() const noexcept {
+        return is_active;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
+
+#endif
\ No newline at end of file
@@ -0,0 +1,313 @@
+/*
+ * @file packet_trace.hpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-29
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#ifndef __PACKET_TRACE_HPP__
+#define __PACKET_TRACE_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "buffer.hpp"
+#include "socket_address.hpp"
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // trace file layout, integers in network order :
+    //     file header : magic "EZSTRACE" (8), version (4), reserved (4).
+    //     records, each starting 8 byte aligned : timestamp in ns (8), source ip (4), source port (2), payload size (2), payload.
+    // a file cut short (e.g. recorder killed) is read up to its last whole record.
+    #define PACKET_TRACE_HEADER_SIZE size_t(16)
+    #define PACKET_TRACE_RECORD_HEADER_SIZE size_t(16)
+    #define PACKET_TRACE_VERSION uint32_t(1)
+
+/* -------------------------------------------------------------------------------- */
+
+    // defined below
+    class PacketTraceReader;
+    // defined in udp_socket.hpp.
+    class UDPSocket;
+
+    /*
+     * class PacketTraceRecord
+     *
+     * a datagram read from a trace file.
+     * payload points into the mapped file and is valid until reader is closed.
+     */
+    class PacketTraceRecord {
+    private:
+        uint64_t timestamp;
+        SocketAddress_IPv4 source;
+        const uint8_t * payload;
+        size_t payload_size;
+
+    private:
+        friend EZSock::PacketTraceReader;
+
+    public:
+        inline PacketTraceRecord() noexcept;
+        PacketTraceRecord(const PacketTraceRecord &) = default;
+        PacketTraceRecord(PacketTraceRecord &&) = default;
+        ~PacketTraceRecord() = default;
+        PacketTraceRecord & operator=(const PacketTraceRecord &) = default;
+        PacketTraceRecord & operator=(PacketTraceRecord &&) = default;
+
+        // to get receive time in ns since epoch.
+        inline uint64_t get_timestamp() const noexcept;
+        // to get source ip & port.
+        inline const SocketAddress_IPv4 & get_source() const noexcept;
+        // to get base address of payload.
+        inline const uint8_t * get_payload() const noexcept;
+        // to get size of payload.
+        inline size_t get_payload_size() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class PacketTraceRecorder
+     *
+     * recorder of datagrams into a trace file.
+     * records are appended to memory chunks, full chunks are written by a background thread,
+     * so the receive path only pays a copy. when every chunk is waiting for disk, records are dropped and counted.
+     * record() must be called from one thread at a time.
+     */
+    class PacketTraceRecorder {
+    private:
+        int file;
+        std::vector<Buffer> chunks;
+        size_t chunk_index;
+        size_t chunk_pos;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<size_t> free_chunks;
+        // index & size of chunks waiting to be written.
+        std::deque<std::pair<size_t, size_t>> full_chunks;
+        std::thread writer;
+
+        uint64_t record_count;
+        std::atomic<uint64_t> drop_count;
+        std::atomic<bool> is_write_failed;
+
+        bool is_active;
+        bool is_stopping;
+
+    private:
+        // to run in background, write full chunks in order.
+        void write_chunks();
+        // to hand current chunk to writer and take a free one. return false if none is free.
+        bool swap_chunk();
+
+    public:
+        // to initialize with size and number of chunks, a chunk must hold the largest record.
+        PacketTraceRecorder(size_t = size_t(1) << 20, size_t = 8);
+        inline ~PacketTraceRecorder();
+
+        // explicitly ban copy and move ctors, writer thread refers to this.
+        PacketTraceRecorder(const PacketTraceRecorder &) = delete;
+        PacketTraceRecorder(PacketTraceRecorder &&) = delete;
+        PacketTraceRecorder & operator=(const PacketTraceRecorder &) = delete;
+        PacketTraceRecorder & operator=(PacketTraceRecorder &&) = delete;
+
+        // to create (or truncate) a trace file and start writer.
+        int open(const char *);
+        // to write everything recorded, stop writer and close file.
+        int close();
+
+        // to record a datagram with timestamp in ns. return -1 if dropped.
+        int record(uint64_t, const SocketAddress_IPv4 &, const uint8_t *, size_t);
+        // to record first n bytes of a buffer, stamped now.
+        int record(const SocketAddress_IPv4 &, const Buffer &, size_t);
+        // to receive datagram from target on socket and record it. return as UDPSocket::receive().
+        ssize_t receive(const UDPSocket &, SocketAddress_IPv4 &);
+        // to hand records so far to writer without waiting for a full chunk.
+        void flush();
+
+        // to get number of datagrams recorded.
+        inline uint64_t get_record_count() const noexcept;
+        // to get number of datagrams dropped (writer behind, too large, or write failed).
+        inline uint64_t get_drop_count() const noexcept;
+        // to get status (true : active, false : closed).
+        inline bool get_status() const noexcept;
+
+        // to get current time in ns since epoch, as stamped on records.
+        static uint64_t get_now() noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class PacketTraceReader
+     *
+     * reader of a trace file mapped into memory, records are not copied.
+     */
+    class PacketTraceReader {
+    private:
+        const uint8_t * file_base;
+        size_t file_size;
+        size_t pos;
+
+        bool is_active;
+
+    public:
+        inline PacketTraceReader() noexcept;
+        inline ~PacketTraceReader();
+
+        // explicitly ban copy and move ctors, mapping is owned.
+        PacketTraceReader(const PacketTraceReader &) = delete;
+        PacketTraceReader(PacketTraceReader &&) = delete;
+        PacketTraceReader & operator=(const PacketTraceReader &) = delete;
+        PacketTraceReader & operator=(PacketTraceReader &&) = delete;
+
+        // to map a trace file. return -1 if it is not one.
+        int open(const char *);
+        // to unmap file.
+        int close();
+
+        // to read next record. return false at end of file.
+        bool next(PacketTraceRecord &) noexcept;
+        // to go back to first record.
+        inline void rewind() noexcept;
+
+        // to get status (true : active, false : closed).
+        inline bool get_status() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class PacketTraceReplayer
+     *
+     * sender of a trace to one target, keeping gaps between records (scaled by speed).
+     * records due at the same moment go out in one sendmmsg(), so rate is bound by batches, not syscalls.
+     * waits sleep until shortly before a deadline and spin the rest.
+     */
+    class PacketTraceReplayer {
+    private:
+        UDPSocket & socket;
+
+        uint64_t sent_count;
+        uint64_t max_lateness;
+        uint64_t total_lateness;
+        uint64_t batch_count;
+
+    public:
+        // to initialize with socket to send from.
+        PacketTraceReplayer(UDPSocket &);
+
+        // to send every record left in reader to target.
+        // speed : 1 original rate, 2 twice as fast, 0 as fast as possible.
+        // return number of datagrams sent, or -1 on error.
+        ssize_t replay(PacketTraceReader &, const SocketAddress_IPv4 &, double = 1.0);
+
+        // to get number of datagrams sent.
+        inline uint64_t get_sent_count() const noexcept;
+        // to get max delay of a batch behind its schedule in ns (not counted at full speed).
+        inline uint64_t get_max_lateness() const noexcept;
+        // to get mean delay of a batch behind its schedule in ns.
+        inline uint64_t get_mean_lateness() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // implements of inline functions.
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketTraceRecord
+
+    inline PacketTraceRecord::PacketTraceRecord() noexcept : timestamp(0), source(), payload(nullptr), payload_size(0) {}
+
+    inline uint64_t PacketTraceRecord::get_timestamp() const noexcept {
+        return timestamp;
+    }
+
+    inline const SocketAddress_IPv4 & PacketTraceRecord::get_source() const noexcept {
+        return source;
+    }
+
+    inline const uint8_t * PacketTraceRecord::get_payload() const noexcept {
+        return payload;
+    }
+
+    inline size_t PacketTraceRecord::get_payload_size() const noexcept {
+        return payload_size;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketTraceRecorder
+
+    inline PacketTraceRecorder::~PacketTraceRecorder() {
+        if(is_active) close();
+    }
+
+    inline uint64_t PacketTraceRecorder::get_record_count() const noexcept {
+        return record_count;
+    }
+
+    inline uint64_t PacketTraceRecorder::get_drop_count() const noexcept {
+        return drop_count;
+    }
+
+    inline bool PacketTraceRecorder::get_status() const noexcept {
+        return is_active;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketTraceReader
+
+    inline PacketTraceReader::PacketTraceReader() noexcept : file_base(nullptr), file_size(0), pos(0), is_active(false) {}
+
+    inline PacketTraceReader::~PacketTraceReader() {
+        if(is_active) close();
+    }
+
+    inline void PacketTraceReader::rewind() noexcept {
+        pos = PACKET_TRACE_HEADER_SIZE;
+    }
+
+    inline bool PacketTraceReader::get_status() const noexcept {
+        return is_active;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketTraceReplayer
+
+    inline uint64_t PacketTraceReplayer::get_sent_count() const noexcept {
+        return sent_count;
+    }
+
+    inline uint64_t PacketTraceReplayer::get_max_lateness() const noexcept {
+        return max_lateness;
+    }
+
+    inline uint64_t PacketTraceReplayer::get_mean_lateness() const noexcept {
+        return batch_count == 0 ? 0 : total_lateness / batch_count;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
+
+#endif
\ No newline at end of file
@@ -0,0 +1,214 @@
+/*
+ * @file shared_memory_socket.hpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-19
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#ifndef __SHARED_MEMORY_SOCKET_HPP__
+#define __SHARED_MEMORY_SOCKET_HPP__
+
+#include <sys/types.h>
+#include <cstdint>
+#include <iosfwd>
+
+#include "buffer.hpp"
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class SharedMemoryPeer
+     *
+     * identifier of one end of a shared memory channel.
+     * the end calling create() is peer 0, the end calling attach() is peer 1.
+     */
+    class SharedMemoryPeer {
+    private:
+        uint32_t peer_id;
+
+    public:
+        // to initialize with a peer id.
+        inline SharedMemoryPeer(uint32_t = 0) noexcept;
+
+        SharedMemoryPeer(const SharedMemoryPeer &) = default;
+        SharedMemoryPeer(SharedMemoryPeer &&) = default;
+        ~SharedMemoryPeer() = default;
+        SharedMemoryPeer & operator=(const SharedMemoryPeer &) = default;
+        SharedMemoryPeer & operator=(SharedMemoryPeer &&) = default;
+
+        // to get peer id.
+        inline uint32_t get_peer_id() const noexcept;
+
+        // to print as "SHM@<peer id>"
+        friend std::ostream & operator<<(std::ostream &, const SharedMemoryPeer &);
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * enum class SharedMemoryWaitMode
+     *
+     * to specify how an empty ring is waited on.
+     * FUTEX : spin briefly, then sleep on a futex in shared memory.
+     * BUSY_POLL : never sleep, lowest latency at cost of a whole core.
+     */
+    enum class SharedMemoryWaitMode {
+        FUTEX,
+        BUSY_POLL,
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class SharedMemorySocket
+     *
+     * same-host transport over two single-producer single-consumer rings in a memfd.
+     * each ring slot holds one datagram of at most the size of the buffer built in.
+     * one side create()s the memfd and hands get_shm_fd() over (e.g. UnixDatagramSocket::send_fd),
+     * the other side attach()es to it. interface follows UDPSocket, with SharedMemoryPeer as address.
+     */
+    class SharedMemorySocket {
+    public:
+        // type of address of peers, to write code generic over transports.
+        using Address = SharedMemoryPeer;
+
+    private:
+        int shm_fd;
+        uint8_t * shm_base;
+        size_t shm_size;
+        uint32_t peer_id;
+        SharedMemoryWaitMode wait_mode;
+
+        bool is_active;
+
+        Buffer buffer;
+
+    private:
+        // to map memfd and check its layout.
+        int map(int, bool);
+
+    public:
+        // to initialize with optional size of buffer (also size of a slot) and wait mode.
+        inline SharedMemorySocket(size_t = 512, SharedMemoryWaitMode = SharedMemoryWaitMode::FUTEX);
+        inline ~SharedMemorySocket();
+
+        // explicitly ban copy and move ctors to keep consistency.
+        SharedMemorySocket(const SharedMemorySocket &) = delete;
+        SharedMemorySocket(SharedMemorySocket &&) = delete;
+        SharedMemorySocket & operator=(const SharedMemorySocket &) = delete;
+        SharedMemorySocket & operator=(SharedMemorySocket &&) = delete;
+
+        // to create a memfd with given number of slots per direction (rounded up to a power of 2).
+        int create(size_t = 1024);
+        // to attach to a memfd created by the other side. descriptor is duplicated.
+        int attach(int);
+        // to unmap memory and close memfd.
+        int close();
+
+        // to send buffer built in to peer.
+        // return -1 (errno EAGAIN) if ring is full, (errno EINVAL) if target is not the peer.
+        inline ssize_t send(const SharedMemoryPeer &) const;
+        // to send specified buffer to peer.
+        inline ssize_t send(const SharedMemoryPeer &, const Buffer &) const;
+        // to send first n bytes of specified buffer to peer.
+        ssize_t send(const SharedMemoryPeer &, const Buffer &, size_t) const;
+        // to receive datagram from peer and store in buffer built in, waiting if ring is empty.
+        ssize_t receive(SharedMemoryPeer &) const;
+        // to receive datagram from peer and store in buffer built in.
+        // peer address will be deserted.
+        inline ssize_t receive() const;
+        // to receive datagram if one is ready, otherwise return -1 (errno EAGAIN).
+        ssize_t try_receive(SharedMemoryPeer &) const;
+
+        // to get memfd, to be handed over to the other side.
+        inline int get_shm_fd() const noexcept;
+        // to get own address.
+        inline SharedMemoryPeer get_socket_address() const noexcept;
+        // to get address of the other side.
+        inline SharedMemoryPeer get_peer_address() const noexcept;
+        // to get status (true : active, false : closed).
+        inline bool get_status() const noexcept;
+        // to get const reference of buffer to read.
+        inline const Buffer & get_buf_ref_const() const noexcept;
+        // to get reference of buffer for read/write.
+        inline Buffer & get_buf_ref() noexcept;
+
+        // to print as "<memfd> - SHM@<peer id> , <is_active>"
+        friend std::ostream & operator<<(std::ostream &, const SharedMemorySocket &);
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // implements of inline functions.
+
+/* -------------------------------------------------------------------------------- */
+
+    // SharedMemoryPeer
+
+    inline SharedMemoryPeer::SharedMemoryPeer(uint32_t src_peer_id) noexcept : peer_id(src_peer_id) {}
+
+    inline uint32_t SharedMemoryPeer::get_peer_id() const noexcept {
+        return peer_id;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // SharedMemorySocket
+
+    inline SharedMemorySocket::SharedMemorySocket(size_t buf_size, SharedMemoryWaitMode src_wait_mode) : shm_fd(-1), shm_base(nullptr), shm_size(0), peer_id(0), wait_mode(src_wait_mode), is_active(false), buffer(buf_size) {}
+
+    inline SharedMemorySocket::~SharedMemorySocket() {
+        if(is_active) close();
+    }
+
+    inline ssize_t SharedMemorySocket::send(const SharedMemoryPeer & target) const {
+        return send(target, buffer, buffer.get_buf_size());
+    }
+
+    inline ssize_t SharedMemorySocket::send(const SharedMemoryPeer & target, const Buffer & src_buf) const {
+        return send(target, src_buf, src_buf.get_buf_size());
+    }
+
+    inline ssize_t SharedMemorySocket::receive() const {
+        auto target = SharedMemoryPeer();
+        return receive(target);
+    }
+
+    inline int SharedMemorySocket::get_shm_fd() const noexcept {
+        return shm_fd;
+    }
+
+    inline SharedMemoryPeer SharedMemorySocket::get_socket_address() const noexcept {
+        return SharedMemoryPeer(peer_id);
+    }
+
+    inline SharedMemoryPeer SharedMemorySocket::get_peer_address() const noexcept {
+        return SharedMemoryPeer(peer_id ^ 1);
+    }
+
+    inline bool SharedMemorySocket::get_status() const noexcept {
+        return is_active;
+    }
+
+    inline const Buffer & SharedMemorySocket::get_buf_ref_const() const noexcept {
+        return buffer;
+    }
+
+    inline Buffer & SharedMemorySocket::get_buf_ref() noexcept {
+        return buffer;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
+
+#endif
\ No newline at end of file
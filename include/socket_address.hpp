@@ -13,6 +13,9 @@
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <cstddef>
+#include <cstring>
 #include <iosfwd>
 
 /* -------------------------------------------------------------------------------- */
@@ -35,6 +38,7 @@ namespace EZSock {
         UNSPEC          = AF_UNSPEC,
         INET            = AF_INET,
         INET6           = AF_INET6,
+        UNIX            = AF_UNIX,
     };
 
 /* -------------------------------------------------------------------------------- */
@@ -122,6 +126,9 @@ namespace EZSock {
         // to get ip (32-bit integer) explicitly.
         inline IPv4_Address_t get() const noexcept;
 
+        // to check if ip is a multicast group (224.0.0.0/4).
+        inline bool is_multicast() const noexcept;
+
         // to print as "xxx.xxx.xxx.xxx".
         inline friend std::ostream & operator<<(std::ostream &, const IPv4_Address &);
 
@@ -174,10 +181,65 @@ namespace EZSock {
         // to get port number.
         inline IPv4_Port get_ipv4_port() const noexcept;
 
+        // to check if ip is a multicast group.
+        inline bool is_multicast() const noexcept;
+
         // to print as "xxx.xxx.xxx.xxx:xxxx"
         friend std::ostream & operator<<(std::ostream &, const SocketAddress_IPv4 &);
     };
 
+/* -------------------------------------------------------------------------------- */
+
+    // defined in unix_datagram_socket.hpp.
+    class UnixDatagramSocket;
+
+    /*
+     * class SocketAddress_Unix
+     *
+     * path of a unix domain socket.
+     * a path beginning with '@' lives in the abstract namespace (no file created).
+     * an empty path means the connected peer, or an autobound name when binding.
+     */
+    class SocketAddress_Unix : public SocketAddress {
+    private:
+        // path without terminating '\0', abstract names start with '\0' instead of '@'.
+        char path[sizeof(sockaddr_un::sun_path)];
+        socklen_t path_size;
+
+    private:
+        friend class EZSock::UnixDatagramSocket;
+
+        // to transfer from & to sockaddr_un struct (built in) explicitly.
+        inline explicit SocketAddress_Unix(const sockaddr_un &, socklen_t) noexcept;
+        inline explicit operator sockaddr_un() const noexcept;
+        // to get length of sockaddr_un actually used.
+        inline socklen_t get_sockaddr_size() const noexcept;
+
+    public:
+        // to initialize with a path.
+        inline SocketAddress_Unix(const char * = "") noexcept;
+
+        SocketAddress_Unix(const SocketAddress_Unix &) = default;
+        SocketAddress_Unix(SocketAddress_Unix &&) = default;
+        ~SocketAddress_Unix() = default;
+        SocketAddress_Unix & operator=(const SocketAddress_Unix &) = default;
+        SocketAddress_Unix & operator=(SocketAddress_Unix &&) = default;
+
+        // socket address type is fixed to SocketAddressFamily::UNIX.
+        void set_socket_address_family() = delete;
+
+        // to change path, too long path is truncated.
+        inline void set_path(const char *) noexcept;
+
+        // to check if path is empty.
+        inline bool is_empty() const noexcept;
+        // to check if path lives in the abstract namespace.
+        inline bool is_abstract() const noexcept;
+
+        // to print as "UNIX@path"
+        friend std::ostream & operator<<(std::ostream &, const SocketAddress_Unix &);
+    };
+
 /* -------------------------------------------------------------------------------- */
 
     // implements of inline functions.
@@ -230,6 +292,10 @@ namespace EZSock {
         return ipv4_address;
     }
 
+    inline bool IPv4_Address::is_multicast() const noexcept {
+        return (ipv4_address & 0xf0000000) == 0xe0000000;
+    }
+
     inline IPv4_Address IPv4_Address::cstr_to_ipv4_address(const char * src_ipv4_str) noexcept {
         return ntohl(inet_addr(src_ipv4_str));
     }
@@ -279,6 +345,60 @@ namespace EZSock {
         return port;
     }
 
+    inline bool SocketAddress_IPv4::is_multicast() const noexcept {
+        return ip.is_multicast();
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // SocketAddress_Unix
+
+    inline SocketAddress_Unix::SocketAddress_Unix(const sockaddr_un & src, socklen_t src_size) noexcept : SocketAddress(SocketAddressFamily::UNIX), path(), path_size(0) {
+        auto offset = socklen_t(offsetof(sockaddr_un, sun_path));
+        if(src_size <= offset) return;
+
+        path_size = src_size - offset;
+        if(path_size > socklen_t(sizeof(path))) path_size = socklen_t(sizeof(path));
+        std::memcpy(path, src.sun_path, path_size);
+
+        // pathname sockets may report terminating '\0'.
+        if(path[0] != '\0') path_size = socklen_t(strnlen(path, path_size));
+    }
+
+    inline SocketAddress_Unix::operator sockaddr_un() const noexcept {
+        auto res = sockaddr_un();
+        res.sun_family = sa_family_t(get_socket_address_family());
+        std::memcpy(res.sun_path, path, path_size);
+
+        return res;
+    }
+
+    inline socklen_t SocketAddress_Unix::get_sockaddr_size() const noexcept {
+        if(path_size == 0) return socklen_t(sizeof(sa_family_t));
+        if(path[0] == '\0') return socklen_t(offsetof(sockaddr_un, sun_path)) + path_size;
+        return socklen_t(offsetof(sockaddr_un, sun_path)) + path_size + (path_size < socklen_t(sizeof(path)) ? 1 : 0);
+    }
+
+    inline SocketAddress_Unix::SocketAddress_Unix(const char * src_path) noexcept : SocketAddress(SocketAddressFamily::UNIX), path(), path_size(0) {
+        set_path(src_path);
+    }
+
+    inline void SocketAddress_Unix::set_path(const char * src_path) noexcept {
+        path_size = socklen_t(strnlen(src_path, sizeof(path)));
+        std::memset(path, 0, sizeof(path));
+        std::memcpy(path, src_path, path_size);
+
+        if(path_size > 0 && path[0] == '@') path[0] = '\0';
+    }
+
+    inline bool SocketAddress_Unix::is_empty() const noexcept {
+        return path_size == 0;
+    }
+
+    inline bool SocketAddress_Unix::is_abstract() const noexcept {
+        return path_size > 0 && path[0] == '\0';
+    }
+
 /* -------------------------------------------------------------------------------- */
 
 }
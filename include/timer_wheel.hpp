@@ -0,0 +1,219 @@
+/*
+ * @file timer_wheel.hpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-08
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#ifndef __TIMER_WHEEL_HPP__
+#define __TIMER_WHEEL_HPP__
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // defined below
+    class TimerWheel;
+
+    /*
+     * class TimerHandle
+     *
+     * returned when a timer is added, used to cancel it later.
+     * a handle becomes stale once its timer expires or is cancelled.
+     */
+    class TimerHandle {
+    private:
+        uint32_t index;
+        uint32_t generation;
+
+    private:
+        friend EZSock::TimerWheel;
+
+        inline TimerHandle(uint32_t, uint32_t) noexcept;
+
+    public:
+        // to initialize as an invalid handle.
+        inline TimerHandle() noexcept;
+
+        TimerHandle(const TimerHandle &) = default;
+        TimerHandle(TimerHandle &&) = default;
+        ~TimerHandle() = default;
+        TimerHandle & operator=(const TimerHandle &) = default;
+        TimerHandle & operator=(TimerHandle &&) = default;
+
+        // to check if handle was ever returned by a TimerWheel.
+        inline bool is_valid() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class TimerWheel
+     *
+     * hierarchical timing wheel (4 levels * 256 slots).
+     * add / cancel are O(1), expiry runs a whole slot at a time.
+     * timers are stored in a pooled node array, so no allocation per timer after warm up.
+     */
+    class TimerWheel {
+    public:
+        using Callback = std::function<void()>;
+        using Clock = std::chrono::steady_clock;
+
+    private:
+        static constexpr uint32_t WHEEL_BITS = 8;
+        static constexpr uint32_t WHEEL_SIZE = uint32_t(1) << WHEEL_BITS;
+        static constexpr uint32_t WHEEL_MASK = WHEEL_SIZE - 1;
+        static constexpr uint32_t WHEEL_LEVELS = 4;
+        static constexpr uint32_t SLOT_COUNT = WHEEL_SIZE * WHEEL_LEVELS;
+        // list of timers being fired right now.
+        static constexpr uint32_t EXPIRING_LIST = SLOT_COUNT;
+        static constexpr uint32_t NIL = UINT32_MAX;
+
+        struct TimerNode {
+            uint64_t expire_tick;
+            uint32_t prev;
+            uint32_t next;
+            uint32_t list;
+            uint32_t generation;
+            bool is_active;
+            Callback callback;
+        };
+
+        Clock::duration tick_duration;
+        Clock::time_point start_time;
+        uint64_t current_tick;
+
+        std::vector<TimerNode> nodes;
+        uint32_t free_head;
+        size_t timer_count;
+
+        uint32_t list_heads[SLOT_COUNT + 1];
+        // one bit per non-empty slot.
+        uint64_t slot_bitmaps[WHEEL_LEVELS][WHEEL_SIZE / 64];
+
+    private:
+        uint32_t alloc_node();
+        void free_node(uint32_t) noexcept;
+
+        void link(uint32_t, uint32_t) noexcept;
+        void unlink(uint32_t) noexcept;
+        // to place a node into the slot matching its expire tick, relative to a reference tick.
+        void place(uint32_t, uint64_t) noexcept;
+        // to move all timers of a higher level slot down the wheel.
+        void cascade(uint32_t, uint64_t) noexcept;
+        // to run all timers of a level 0 slot.
+        size_t fire(uint32_t);
+
+        // to find first non-empty slot in [pos, WHEEL_SIZE) of a level, WHEEL_SIZE if none.
+        inline uint32_t find_slot(uint32_t, uint32_t) const noexcept;
+
+    public:
+        // to initialize with length of one tick (1 ms by default).
+        TimerWheel(Clock::duration = std::chrono::milliseconds(1));
+
+        // explicitly ban copy and move ctors, handles refer to this instance.
+        TimerWheel(const TimerWheel &) = delete;
+        TimerWheel(TimerWheel &&) = delete;
+        TimerWheel & operator=(const TimerWheel &) = delete;
+        TimerWheel & operator=(TimerWheel &&) = delete;
+
+        // to add a timer firing at given tick. ticks already passed fire on next expiry.
+        TimerHandle add_timer_at(uint64_t, Callback);
+        // to add a timer firing given number of ticks after last processed tick.
+        inline TimerHandle add_timer(uint64_t, Callback);
+        // to add a timer firing given duration from now (rounded up to ticks).
+        inline TimerHandle add_timer(Clock::duration, Callback);
+        // to cancel a timer. return false if it has already fired or been cancelled.
+        bool cancel_timer(TimerHandle &) noexcept;
+
+        // to run all timers due up to given tick. return number of timers fired.
+        size_t expire(uint64_t);
+        // to run all timers due by now. return number of timers fired.
+        inline size_t expire();
+
+        // to get ticks until the wheel needs attention again, -1 if no timer pending.
+        // it may be earlier than the real deadline when a higher level slot has to cascade.
+        int64_t get_next_timeout_ticks() const noexcept;
+        // to get milliseconds until the wheel needs attention again, -1 if no timer pending.
+        // fits the timeout parameter of poll().
+        int get_next_timeout() const noexcept;
+
+        // to get tick of now according to clock.
+        inline uint64_t get_now_tick() const noexcept;
+        // to get last processed tick.
+        inline uint64_t get_current_tick() const noexcept;
+        // to get number of pending timers.
+        inline size_t get_timer_count() const noexcept;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // implements of inline functions.
+
+/* -------------------------------------------------------------------------------- */
+
+    // TimerHandle
+
+    inline TimerHandle::TimerHandle(uint32_t src_index, uint32_t src_generation) noexcept : index(src_index), generation(src_generation) {}
+
+    inline TimerHandle::TimerHandle() noexcept : index(UINT32_MAX), generation(0) {}
+
+    inline bool TimerHandle::is_valid() const noexcept {
+        return index != UINT32_MAX;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // TimerWheel
+
+    inline uint32_t TimerWheel::find_slot(uint32_t level, uint32_t pos) const noexcept {
+        while(pos < WHEEL_SIZE){
+            auto word = slot_bitmaps[level][pos / 64] >> (pos % 64);
+            if(word != 0) return pos + uint32_t(__builtin_ctzll(word));
+            pos = (pos / 64 + 1) * 64;
+        }
+        return WHEEL_SIZE;
+    }
+
+    inline TimerHandle TimerWheel::add_timer(uint64_t delay_ticks, Callback callback) {
+        return add_timer_at(current_tick + delay_ticks, std::move(callback));
+    }
+
+    inline TimerHandle TimerWheel::add_timer(Clock::duration delay, Callback callback) {
+        auto delay_ticks = delay.count() <= 0 ? uint64_t(0) : uint64_t((delay + tick_duration - Clock::duration(1)) / tick_duration);
+        return add_timer_at(get_now_tick() + delay_ticks, std::move(callback));
+    }
+
+    inline size_t TimerWheel::expire() {
+        return expire(get_now_tick());
+    }
+
+    inline uint64_t TimerWheel::get_now_tick() const noexcept {
+        return uint64_t((Clock::now() - start_time) / tick_duration);
+    }
+
+    inline uint64_t TimerWheel::get_current_tick() const noexcept {
+        return current_tick;
+    }
+
+    inline size_t TimerWheel::get_timer_count() const noexcept {
+        return timer_count;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
+
+#endif
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <iosfwd>
+#include <vector>
 
 #include "buffer.hpp"
 #include "socket_address.hpp"
@@ -23,6 +24,11 @@
 
 namespace EZSock {
 
+/* -------------------------------------------------------------------------------- */
+
+    // defined in timer_wheel.hpp.
+    class TimerWheel;
+
 /* -------------------------------------------------------------------------------- */
 
     /*
@@ -32,6 +38,10 @@ namespace EZSock {
      * OOP feature makes it simple.
      */
     class UDPSocket {
+    public:
+        // type of address of peers, to write code generic over transports.
+        using Address = SocketAddress_IPv4;
+
     private:
         int socket;
         SocketAddress_IPv4 socket_address_ipv4;
@@ -60,11 +70,45 @@ namespace EZSock {
         inline ssize_t send(const SocketAddress_IPv4 &) const;
         // to send specified buffer to target.
         inline ssize_t send(const SocketAddress_IPv4 &, const Buffer &) const;
+        // to send first n bytes of specified buffer to target.
+        inline ssize_t send(const SocketAddress_IPv4 &, const Buffer &, size_t) const;
         // to receive datagram from target and store in buffer built in.
         inline ssize_t receive(SocketAddress_IPv4 &) const;
         // to receive datagram from target and store in buffer built in.
         // target address will be deserted.
         inline ssize_t receive() const;
+        // to receive datagram and the address it was sent to (multicast group or local ip).
+        // destination is only known after join_group() or set_packet_info(true).
+        ssize_t receive(SocketAddress_IPv4 &, IPv4_Address &) const;
+        // to receive datagram from target while running timers of the wheel.
+        // blocking : wait with timeout derived from next deadline until a datagram arrives.
+        // non-blocking : run due timers, then return -1 (errno EAGAIN) if no datagram is queued.
+        ssize_t receive(SocketAddress_IPv4 &, TimerWheel &, bool = true) const;
+
+        // to send first n bytes of specified buffer to every target, batched by sendmmsg.
+        // return number of datagrams sent, or -1 if none could be sent.
+        ssize_t send_to_all(const std::vector<SocketAddress_IPv4> &, const Buffer &, size_t) const;
+
+        // to join a multicast group on an interface (any by default).
+        // kernel then only delivers groups joined by this socket.
+        int join_group(const IPv4_Address &, const IPv4_Address & = AUTO_IPV4_ADDRESS);
+        // to leave a multicast group.
+        int leave_group(const IPv4_Address &, const IPv4_Address & = AUTO_IPV4_ADDRESS);
+        // to join a multicast group, accepting datagrams from given source only.
+        // parameters : group, source, interface.
+        int join_source_group(const IPv4_Address &, const IPv4_Address &, const IPv4_Address & = AUTO_IPV4_ADDRESS);
+        // to leave a source specific membership.
+        int leave_source_group(const IPv4_Address &, const IPv4_Address &, const IPv4_Address & = AUTO_IPV4_ADDRESS);
+        // to set ttl of outgoing multicast datagrams.
+        int set_multicast_ttl(uint8_t);
+        // to set whether outgoing multicast datagrams loop back to local receivers.
+        int set_multicast_loop(bool);
+        // to set interface of outgoing multicast datagrams.
+        int set_multicast_interface(const IPv4_Address &);
+        // to set whether groups joined by other sockets are delivered as well (IP_MULTICAST_ALL).
+        int set_multicast_all(bool);
+        // to set whether destination address of each datagram is reported (IP_PKTINFO).
+        int set_packet_info(bool);
 
         // to get socket.
         inline int get_socket() const noexcept;
@@ -116,6 +160,15 @@ namespace EZSock {
         return ::sendto(socket, src_buf.get_buf_base(), src_buf.get_buf_size(), 0, &sockaddr_tmp, sizeof(sockaddr));
     }
 
+    inline ssize_t UDPSocket::send(const SocketAddress_IPv4 & target, const Buffer & src_buf, size_t size) const {
+        if(!is_active) return -1;
+
+        if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+
+        auto sockaddr_tmp = sockaddr(target);
+        return ::sendto(socket, src_buf.get_buf_base(), size, 0, &sockaddr_tmp, sizeof(sockaddr));
+    }
+
     inline ssize_t UDPSocket::receive(SocketAddress_IPv4 & target) const {
         if(!is_active) return -1;
 
@@ -0,0 +1,223 @@
+/*
+ * @file unix_datagram_socket.hpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-16
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#ifndef __UNIX_DATAGRAM_SOCKET_HPP__
+#define __UNIX_DATAGRAM_SOCKET_HPP__
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <iosfwd>
+
+#include "buffer.hpp"
+#include "socket_address.hpp"
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * enum class UnixSocketType
+     *
+     * to specify type of unix domain socket.
+     * SEQPACKET keeps message boundaries like DATAGRAM, but is connection oriented.
+     */
+    enum class UnixSocketType : int {
+        DATAGRAM        = SOCK_DGRAM,
+        SEQPACKET       = SOCK_SEQPACKET,
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class UnixDatagramSocket
+     *
+     * unix domain counterpart of UDPSocket, with same send / receive / Buffer interface.
+     * an empty SocketAddress_Unix as target means the connected peer.
+     */
+    class UnixDatagramSocket {
+    public:
+        // type of address of peers, to write code generic over transports.
+        using Address = SocketAddress_Unix;
+
+    private:
+        int socket;
+        SocketAddress_Unix socket_address_unix;
+        UnixSocketType socket_type;
+
+        bool is_active;
+
+        Buffer buffer;
+
+    private:
+        // to replace socket with an already opened one.
+        void adopt(int) noexcept;
+
+    public:
+        // to initialize with optional size of buffer and socket type.
+        inline UnixDatagramSocket(size_t = 512, UnixSocketType = UnixSocketType::DATAGRAM);
+        inline ~UnixDatagramSocket();
+
+        // explicitly ban copy and move ctors to keep consistency.
+        UnixDatagramSocket(const UnixDatagramSocket &) = delete;
+        UnixDatagramSocket(UnixDatagramSocket &&) = delete;
+        UnixDatagramSocket & operator=(const UnixDatagramSocket &) = delete;
+        UnixDatagramSocket & operator=(UnixDatagramSocket &&) = delete;
+
+        // to bind with a socket address. an empty path binds to an autobound abstract name.
+        int bind(const SocketAddress_Unix &);
+        // to connect to a peer, so that empty targets reach it.
+        int connect(const SocketAddress_Unix &);
+        // to listen for SEQPACKET connections.
+        int listen(int = 16);
+        // to accept a SEQPACKET connection into another (unused) socket.
+        int accept(UnixDatagramSocket &);
+        // to close socket.
+        inline int close();
+
+        // to connect two sockets to each other (socketpair), replacing their current sockets.
+        static int pair(UnixDatagramSocket &, UnixDatagramSocket &);
+
+        // to send buffer built in to target.
+        inline ssize_t send(const SocketAddress_Unix &) const;
+        // to send specified buffer to target.
+        inline ssize_t send(const SocketAddress_Unix &, const Buffer &) const;
+        // to send first n bytes of specified buffer to target.
+        inline ssize_t send(const SocketAddress_Unix &, const Buffer &, size_t) const;
+        // to receive datagram from target and store in buffer built in.
+        inline ssize_t receive(SocketAddress_Unix &) const;
+        // to receive datagram from target and store in buffer built in.
+        // target address will be deserted.
+        inline ssize_t receive() const;
+
+        // to send first n bytes of specified buffer together with a file descriptor (SCM_RIGHTS).
+        // descriptor stays open on this side.
+        ssize_t send_fd(const SocketAddress_Unix &, int, const Buffer &, size_t) const;
+        // to receive datagram and an attached file descriptor (-1 if none) into buffer built in.
+        // descriptor is owned by caller, and is close-on-exec.
+        ssize_t receive_fd(SocketAddress_Unix &, int &) const;
+
+        // to create a memfd of given size to hand large payloads over by send_fd.
+        // size is sealed, so a receiver can map it without fear of SIGBUS. return -1 on failure.
+        static int create_memfd(const char *, size_t);
+
+        // to get socket.
+        inline int get_socket() const noexcept;
+        // to get binded socket address.
+        inline SocketAddress_Unix get_socket_address() const noexcept;
+        // to get socket type.
+        inline UnixSocketType get_socket_type() const noexcept;
+        // to get status (true : active, false : closed).
+        inline bool get_status() const noexcept;
+        // to get const reference of buffer to read.
+        inline const Buffer & get_buf_ref_const() const noexcept;
+        // to get reference of buffer for read/write.
+        inline Buffer & get_buf_ref() noexcept;
+
+        // to print as "<socket> - UNIX@path , <is_active>"
+        friend std::ostream & operator<<(std::ostream &, const UnixDatagramSocket &);
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // implements of inline functions.
+
+/* -------------------------------------------------------------------------------- */
+
+    // UnixDatagramSocket
+
+    inline UnixDatagramSocket::UnixDatagramSocket(size_t buf_size, UnixSocketType src_socket_type) : socket(::socket(AF_UNIX, int(src_socket_type) | SOCK_CLOEXEC, 0)), socket_address_unix(), socket_type(src_socket_type), is_active(false), buffer(buf_size) {}
+
+    inline UnixDatagramSocket::~UnixDatagramSocket() {
+        if(is_active) close();
+        else if(socket >= 0) ::close(socket);
+    }
+
+    inline int UnixDatagramSocket::close() {
+        auto res = ::close(socket);
+        is_active = res == 0 ? false : true;
+        if(res == 0) socket = -1;
+
+        return res;
+    }
+
+    inline ssize_t UnixDatagramSocket::send(const SocketAddress_Unix & target) const {
+        return send(target, buffer, buffer.get_buf_size());
+    }
+
+    inline ssize_t UnixDatagramSocket::send(const SocketAddress_Unix & target, const Buffer & src_buf) const {
+        return send(target, src_buf, src_buf.get_buf_size());
+    }
+
+    inline ssize_t UnixDatagramSocket::send(const SocketAddress_Unix & target, const Buffer & src_buf, size_t size) const {
+        if(!is_active) return -1;
+
+        if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+
+        if(target.is_empty()) return ::send(socket, src_buf.get_buf_base(), size, MSG_NOSIGNAL);
+
+        auto sockaddr_tmp = sockaddr_un(target);
+        return ::sendto(socket, src_buf.get_buf_base(), size, MSG_NOSIGNAL, (sockaddr *)&sockaddr_tmp, target.get_sockaddr_size());
+    }
+
+    inline ssize_t UnixDatagramSocket::receive(SocketAddress_Unix & target) const {
+        if(!is_active) return -1;
+
+        auto sockaddr_tmp = sockaddr_un();
+        auto socklen_tmp = socklen_t(sizeof(sockaddr_un));
+
+        auto res = ::recvfrom(socket, (void *)buffer.get_buf_base(), buffer.get_buf_size(), 0, (sockaddr *)&sockaddr_tmp, &socklen_tmp);
+
+        target = SocketAddress_Unix(sockaddr_tmp, res < 0 ? 0 : socklen_tmp);
+
+        return res;
+    }
+
+    inline ssize_t UnixDatagramSocket::receive() const {
+        if(!is_active) return -1;
+
+        return ::recv(socket, (void *)buffer.get_buf_base(), buffer.get_buf_size(), 0);
+    }
+
+    inline int UnixDatagramSocket::get_socket() const noexcept {
+        return socket;
+    }
+
+    inline SocketAddress_Unix UnixDatagramSocket::get_socket_address() const noexcept {
+        if(!is_active) return SocketAddress_Unix();
+
+        return socket_address_unix;
+    }
+
+    inline UnixSocketType UnixDatagramSocket::get_socket_type() const noexcept {
+        return socket_type;
+    }
+
+    inline bool UnixDatagramSocket::get_status() const noexcept {
+        return is_active;
+    }
+
+    inline const Buffer & UnixDatagramSocket::get_buf_ref_const() const noexcept {
+        return buffer;
+    }
+
+    inline Buffer & UnixDatagramSocket::get_buf_ref() noexcept {
+        return buffer;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
+
+#endif
\ No newline at end of file
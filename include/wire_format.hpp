@@ -0,0 +1,468 @@
+/*
+ * @file wire_format.hpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-25
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#ifndef __WIRE_FORMAT_HPP__
+#define __WIRE_FORMAT_HPP__
+
+#include <sys/types.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "buffer.hpp"
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class BoundedArray
+     *
+     * up to capacity elements stored inline, value type of WireArray.
+     */
+    template<typename T, size_t capacity>
+    class BoundedArray {
+    private:
+        T elements[capacity];
+        size_t size;
+
+    public:
+        inline BoundedArray() : elements(), size(0) {}
+
+        BoundedArray(const BoundedArray &) = default;
+        BoundedArray(BoundedArray &&) = default;
+        ~BoundedArray() = default;
+        BoundedArray & operator=(const BoundedArray &) = default;
+        BoundedArray & operator=(BoundedArray &&) = default;
+
+        // to read an element, no range check.
+        inline const T & operator[](size_t pos) const noexcept { return elements[pos]; }
+        // to modify an element, no range check.
+        inline T & operator[](size_t pos) noexcept { return elements[pos]; }
+
+        // to append an element. return false if full.
+        inline bool push_back(const T & element) noexcept(std::is_nothrow_copy_assignable<T>::value) {
+            if(size == capacity) return false;
+            elements[size ++] = element;
+            return true;
+        }
+
+        // to set number of elements, clamped to capacity.
+        inline void set_size(size_t src_size) noexcept { size = src_size < capacity ? src_size : capacity; }
+        // to get number of elements.
+        inline size_t get_size() const noexcept { return size; }
+        // to get max number of elements.
+        static constexpr size_t get_capacity() noexcept { return capacity; }
+
+        // to get base address of elements.
+        inline T * get_data() noexcept { return elements; }
+        // to get base address of elements.
+        // const version.
+        inline const T * get_data() const noexcept { return elements; }
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * wire codecs
+     *
+     * every codec describes how one value is laid out on the wire :
+     *     Value                         : type of value.
+     *     MIN_SIZE / MAX_SIZE           : bounds of encoded size, equal for fixed size codecs.
+     *     get_size(value)               : exact encoded size.
+     *     encode(dst, value)            : to write value, dst has room for MAX_SIZE. return size written.
+     *     decode(src, size, value)      : to read value from at most size bytes. return size read, 0 if malformed.
+     *                                     fixed size codecs trust that MAX_SIZE bytes are there.
+     */
+
+    /*
+     * class WireInt
+     *
+     * fixed width integer (or enum) in network byte order.
+     */
+    template<typename T>
+    class WireInt {
+    private:
+        static_assert((std::is_integral<T>::value && !std::is_same<T, bool>::value) || std::is_enum<T>::value, "WireInt needs an integer or enum type");
+
+        using Integer = typename std::conditional_t<std::is_enum<T>::value, std::underlying_type<T>, std::common_type<T>>::type;
+        using Unsigned = std::make_unsigned_t<Integer>;
+
+    public:
+        using Value = T;
+
+        static constexpr size_t MIN_SIZE = sizeof(T);
+        static constexpr size_t MAX_SIZE = sizeof(T);
+
+        static constexpr size_t get_size(const T &) noexcept {
+            return sizeof(T);
+        }
+
+        // to swap between host & network byte order.
+        static inline Unsigned swap_bytes(Unsigned bits) noexcept {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            if constexpr (sizeof(T) == 2) return __builtin_bswap16(bits);
+            if constexpr (sizeof(T) == 4) return __builtin_bswap32(bits);
+            if constexpr (sizeof(T) == 8) return __builtin_bswap64(bits);
+#endif
+            return bits;
+        }
+
+        // memcpy instead of casts : no alignment needs, compiles down to a bswap & store.
+        static inline size_t encode(uint8_t * dst, const T & value) noexcept {
+            auto bits = swap_bytes(Unsigned(value));
+            std::memcpy(dst, &bits, sizeof(T));
+            return sizeof(T);
+        }
+
+        static inline size_t decode(const uint8_t * src, size_t, T & value) noexcept {
+            auto bits = Unsigned();
+            std::memcpy(&bits, src, sizeof(T));
+            value = T(Integer(swap_bytes(bits)));
+            return sizeof(T);
+        }
+    };
+
+    /*
+     * class WireVarint
+     *
+     * LEB128 variable length integer, 7 bits per byte, low bits first.
+     * signed types are zigzag encoded, so small negative numbers stay short.
+     */
+    template<typename T>
+    class WireVarint {
+    private:
+        static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value, "WireVarint needs an integer type");
+
+        using Unsigned = std::make_unsigned_t<T>;
+
+    public:
+        using Value = T;
+
+        static constexpr size_t MIN_SIZE = 1;
+        static constexpr size_t MAX_SIZE = (sizeof(T) * 8 + 6) / 7;
+        // number of value bits the last byte may carry.
+        static constexpr size_t LAST_BYTE_BITS = sizeof(T) * 8 - 7 * (MAX_SIZE - 1);
+
+        static inline Unsigned to_unsigned(const T & value) noexcept {
+            if constexpr (std::is_signed<T>::value) return (Unsigned(value) << 1) ^ Unsigned(value >> (sizeof(T) * 8 - 1));
+            else return value;
+        }
+
+        static inline T from_unsigned(Unsigned bits) noexcept {
+            if constexpr (std::is_signed<T>::value) return T((bits >> 1) ^ (~(bits & 1) + 1));
+            else return bits;
+        }
+
+        static inline size_t get_size(const T & value) noexcept {
+            auto bits = to_unsigned(value);
+            auto size = size_t(1);
+            while(bits >= 0x80){
+                bits >>= 7;
+                size ++;
+            }
+            return size;
+        }
+
+        static inline size_t encode(uint8_t * dst, const T & value) noexcept {
+            auto bits = to_unsigned(value);
+            auto size = size_t(0);
+            while(bits >= 0x80){
+                dst[size ++] = uint8_t(bits) | 0x80;
+                bits >>= 7;
+            }
+            dst[size ++] = uint8_t(bits);
+            return size;
+        }
+
+        static inline size_t decode(const uint8_t * src, size_t size, T & value) noexcept {
+            auto bits = Unsigned(0);
+            auto limit = size < MAX_SIZE ? size : MAX_SIZE;
+            for(size_t i = 0; i < limit; i ++){
+                // bits beyond the width of T would be lost, the value does not fit.
+                if(i == MAX_SIZE - 1 && (src[i] & 0x7f) >> LAST_BYTE_BITS != 0) return 0;
+                bits |= Unsigned(src[i] & 0x7f) << (7 * i);
+                if((src[i] & 0x80) == 0){
+                    value = from_unsigned(bits);
+                    return i + 1;
+                }
+            }
+            return 0;
+        }
+    };
+
+    /*
+     * class WireBytes
+     *
+     * N raw bytes.
+     */
+    template<size_t N>
+    class WireBytes {
+    public:
+        using Value = std::array<uint8_t, N>;
+
+        static constexpr size_t MIN_SIZE = N;
+        static constexpr size_t MAX_SIZE = N;
+
+        static constexpr size_t get_size(const Value &) noexcept {
+            return N;
+        }
+
+        static inline size_t encode(uint8_t * dst, const Value & value) noexcept {
+            std::memcpy(dst, value.data(), N);
+            return N;
+        }
+
+        static inline size_t decode(const uint8_t * src, size_t, Value & value) noexcept {
+            std::memcpy(value.data(), src, N);
+            return N;
+        }
+    };
+
+    /*
+     * class WireArray
+     *
+     * up to N elements of an element codec, after an element count of the narrowest fitting width.
+     */
+    template<typename Codec, size_t N>
+    class WireArray {
+    private:
+        using Element = typename Codec::Value;
+        using Count = std::conditional_t<(N < 0x100), uint8_t, std::conditional_t<(N < 0x10000), uint16_t, uint32_t>>;
+        using CountCodec = WireInt<Count>;
+
+        static constexpr bool IS_ELEMENT_FIXED_SIZE = Codec::MIN_SIZE == Codec::MAX_SIZE;
+        // arrays of single bytes are copied as a whole.
+        static constexpr bool IS_RAW_BYTES = std::is_same<Codec, WireInt<uint8_t>>::value || std::is_same<Codec, WireInt<int8_t>>::value;
+
+    public:
+        using Value = BoundedArray<Element, N>;
+
+        static constexpr size_t MIN_SIZE = CountCodec::MAX_SIZE;
+        static constexpr size_t MAX_SIZE = CountCodec::MAX_SIZE + N * Codec::MAX_SIZE;
+
+        static inline size_t get_size(const Value & value) noexcept {
+            if constexpr (IS_ELEMENT_FIXED_SIZE) return CountCodec::MAX_SIZE + value.get_size() * Codec::MAX_SIZE;
+
+            auto size = CountCodec::MAX_SIZE;
+            for(size_t i = 0; i < value.get_size(); i ++) size += Codec::get_size(value[i]);
+            return size;
+        }
+
+        static inline size_t encode(uint8_t * dst, const Value & value) noexcept {
+            auto count = value.get_size();
+            auto size = CountCodec::encode(dst, Count(count));
+
+            if constexpr (IS_RAW_BYTES){
+                std::memcpy(dst + size, value.get_data(), count);
+                return size + count;
+            }
+
+            for(size_t i = 0; i < count; i ++) size += Codec::encode(dst + size, value[i]);
+            return size;
+        }
+
+        static inline size_t decode(const uint8_t * src, size_t size, Value & value) noexcept {
+            if(size < CountCodec::MAX_SIZE) return 0;
+
+            auto count = Count();
+            auto pos = CountCodec::decode(src, size, count);
+            if(count > N) return 0;
+            value.set_size(count);
+
+            if constexpr (IS_ELEMENT_FIXED_SIZE){
+                // one bound check for the whole array.
+                if(size - pos < count * Codec::MAX_SIZE) return 0;
+
+                if constexpr (IS_RAW_BYTES){
+                    std::memcpy(value.get_data(), src + pos, count);
+                    return pos + count;
+                }
+
+                for(size_t i = 0; i < count; i ++) pos += Codec::decode(src + pos, Codec::MAX_SIZE, value[i]);
+                return pos;
+            }
+
+            for(size_t i = 0; i < count; i ++){
+                auto element_size = Codec::decode(src + pos, size - pos, value[i]);
+                if(element_size == 0) return 0;
+                pos += element_size;
+            }
+            return pos;
+        }
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class WireDefaultCodec
+     *
+     * codec picked for a member when WireField is not told one.
+     * integers & enums : WireInt, std::array<uint8_t, N> : WireBytes, BoundedArray : WireArray.
+     */
+    template<typename T>
+    class WireDefaultCodec {
+    private:
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "no default wire codec for this type, name one in WireField");
+
+    public:
+        using Type = WireInt<T>;
+    };
+
+    template<size_t N>
+    class WireDefaultCodec<std::array<uint8_t, N>> {
+    public:
+        using Type = WireBytes<N>;
+    };
+
+    template<typename T, size_t N>
+    class WireDefaultCodec<BoundedArray<T, N>> {
+    public:
+        using Type = WireArray<typename WireDefaultCodec<T>::Type, N>;
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    // to split a pointer to member into class & member types.
+    template<typename T>
+    class WireMemberTraits;
+
+    template<typename C, typename M>
+    class WireMemberTraits<M C::*> {
+    public:
+        using Class = C;
+        using Member = M;
+    };
+
+    /*
+     * class WireField
+     *
+     * one member of a message and the codec it is written with.
+     */
+    template<auto member, typename Codec = typename WireDefaultCodec<typename WireMemberTraits<decltype(member)>::Member>::Type>
+    class WireField {
+    public:
+        using Class = typename WireMemberTraits<decltype(member)>::Class;
+        using Member = typename WireMemberTraits<decltype(member)>::Member;
+
+    private:
+        static_assert(std::is_same<typename Codec::Value, Member>::value, "codec does not match type of member");
+
+    public:
+        static constexpr size_t MIN_SIZE = Codec::MIN_SIZE;
+        static constexpr size_t MAX_SIZE = Codec::MAX_SIZE;
+        static constexpr bool IS_FIXED_SIZE = MIN_SIZE == MAX_SIZE;
+
+        static inline size_t get_size(const Class & message) noexcept {
+            return Codec::get_size(message.*member);
+        }
+
+        static inline size_t encode(uint8_t * dst, const Class & message) noexcept {
+            return Codec::encode(dst, message.*member);
+        }
+
+        static inline size_t decode(const uint8_t * src, size_t size, Class & message) noexcept {
+            return Codec::decode(src, size, message.*member);
+        }
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+    /*
+     * class WireFormat
+     *
+     * layout of a message : its fields in wire order.
+     * sizes are known at compile time, so a Buffer can be sized by MAX_SIZE once,
+     * and a fixed size message is checked against buffer size a single time.
+     *
+     * e.g.
+     *     struct FileHeader { int32_t packet_count; BoundedArray<uint8_t, 64> name; };
+     *     using FileHeaderFormat = WireFormat<WireField<&FileHeader::packet_count>, WireField<&FileHeader::name>>;
+     *     auto buffer = Buffer(FileHeaderFormat::MAX_SIZE);
+     */
+    template<typename First, typename... Rest>
+    class WireFormat {
+    public:
+        using Message = typename First::Class;
+
+    private:
+        static_assert((std::is_same<typename Rest::Class, Message>::value && ...), "fields belong to different messages");
+
+        // to decode a field, checking what is left when sizes vary.
+        template<typename Field>
+        static inline bool decode_field(const uint8_t * src, size_t size, size_t & pos, Message & message) noexcept {
+            if constexpr (Field::IS_FIXED_SIZE){
+                if(size - pos < Field::MAX_SIZE) return false;
+                pos += Field::decode(src + pos, Field::MAX_SIZE, message);
+                return true;
+            }
+
+            auto field_size = Field::decode(src + pos, size - pos, message);
+            pos += field_size;
+            return field_size != 0;
+        }
+
+    public:
+        static constexpr size_t MIN_SIZE = (First::MIN_SIZE + ... + Rest::MIN_SIZE);
+        static constexpr size_t MAX_SIZE = (First::MAX_SIZE + ... + Rest::MAX_SIZE);
+        static constexpr bool IS_FIXED_SIZE = MIN_SIZE == MAX_SIZE;
+
+        // to get exact encoded size of a message.
+        static inline size_t get_size(const Message & message) noexcept {
+            if constexpr (IS_FIXED_SIZE) return MAX_SIZE;
+            return (First::get_size(message) + ... + Rest::get_size(message));
+        }
+
+        // to encode a message into memory. return size written, or -1 if it does not fit.
+        static inline ssize_t encode(const Message & message, uint8_t * dst, size_t size) noexcept {
+            if(size < MAX_SIZE && size < get_size(message)) return -1;
+
+            auto pos = First::encode(dst, message);
+            ((pos += Rest::encode(dst + pos, message)), ...);
+            return ssize_t(pos);
+        }
+
+        // to encode a message at the beginning of a buffer.
+        static inline ssize_t encode(const Message & message, Buffer & dst_buf) noexcept {
+            return encode(message, dst_buf.get_buf_base(), dst_buf.get_buf_size());
+        }
+
+        // to decode a message from memory. return size read, or -1 if truncated / malformed.
+        static inline ssize_t decode(const uint8_t * src, size_t size, Message & message) noexcept {
+            if constexpr (IS_FIXED_SIZE){
+                if(size < MAX_SIZE) return -1;
+
+                auto pos = First::decode(src, First::MAX_SIZE, message);
+                ((pos += Rest::decode(src + pos, Rest::MAX_SIZE, message)), ...);
+                return ssize_t(pos);
+            }
+
+            auto pos = size_t(0);
+            auto is_valid = decode_field<First>(src, size, pos, message) && (decode_field<Rest>(src, size, pos, message) && ...);
+            return is_valid ? ssize_t(pos) : -1;
+        }
+
+        // to decode a message from first n bytes of a buffer.
+        static inline ssize_t decode(const Buffer & src_buf, size_t size, Message & message) noexcept {
+            if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+            return decode(src_buf.get_buf_base(), size, message);
+        }
+    };
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
+
+#endif
\ No newline at end of file
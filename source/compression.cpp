@@ -0,0 +1,318 @@
+/*
+ * @file compression.cpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-27
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#include "compression.hpp"
+#include "udp_socket.hpp"
+#include "wire_format.hpp"
+#include <cstring>
+
+#ifdef EZSOCK_WITH_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef EZSOCK_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+/* -------------------------------------------------------------------------------- */
+
+// utilities
+
+// header in front of every frame.
+struct CompressionHeader {
+    uint8_t codec;
+    uint32_t dictionary_id;
+    uint32_t original_size;
+};
+
+using CompressionHeaderFormat = EZSock::WireFormat<
+    EZSock::WireField<&CompressionHeader::codec>,
+    EZSock::WireField<&CompressionHeader::dictionary_id, EZSock::WireVarint<uint32_t>>,
+    EZSock::WireField<&CompressionHeader::original_size, EZSock::WireVarint<uint32_t>>
+>;
+
+static_assert(CompressionHeaderFormat::MAX_SIZE == COMPRESSION_HEADER_MAX_SIZE, "COMPRESSION_HEADER_MAX_SIZE is out of date");
+
+// chunks smaller than this are always stored.
+static constexpr size_t MIN_COMPRESSED_SIZE = 64;
+// max number of chunks stored without trying after compression did not pay.
+static constexpr uint32_t MAX_SKIP_BACKOFF = 64;
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // CompressionDictionary
+
+    // content is sized to what src_buf really holds, lz4 decompression passes its whole size as dictionary.
+    CompressionDictionary::CompressionDictionary(uint32_t src_id, const Buffer & src_buf, size_t size, int zstd_level) : id(src_id), content(size < src_buf.get_buf_size() ? size : src_buf.get_buf_size()), lz4_stream(nullptr), zstd_cdict(nullptr), zstd_ddict(nullptr) {
+        size = content.get_buf_size();
+        std::memcpy(content.get_buf_base(), src_buf.get_buf_base(), size);
+
+#ifdef EZSOCK_WITH_LZ4
+        lz4_stream = LZ4_createStream();
+        LZ4_loadDict((LZ4_stream_t *)lz4_stream, (const char *)content.get_buf_base(), int(size));
+#endif
+
+#ifdef EZSOCK_WITH_ZSTD
+        zstd_cdict = ZSTD_createCDict(content.get_buf_base(), size, zstd_level);
+        zstd_ddict = ZSTD_createDDict(content.get_buf_base(), size);
+#else
+        (void)zstd_level;
+#endif
+    }
+
+    CompressionDictionary::~CompressionDictionary() {
+#ifdef EZSOCK_WITH_LZ4
+        LZ4_freeStream((LZ4_stream_t *)lz4_stream);
+#endif
+
+#ifdef EZSOCK_WITH_ZSTD
+        ZSTD_freeCDict((ZSTD_CDict *)zstd_cdict);
+        ZSTD_freeDDict((ZSTD_DDict *)zstd_ddict);
+#endif
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // Compressor
+
+    Compressor::Compressor(CompressionCodec src_codec, int src_level) : codec(src_codec), level(src_level), dictionary(nullptr), lz4_stream(nullptr), zstd_cctx(nullptr), skip_count(0), skip_backoff(0), input_size(0), output_size(0), stored_count(0), compressed_count(0) {
+        if(!is_available(codec)) codec = CompressionCodec::STORE;
+
+#ifdef EZSOCK_WITH_LZ4
+        if(codec == CompressionCodec::LZ4) lz4_stream = LZ4_createStream();
+#endif
+
+#ifdef EZSOCK_WITH_ZSTD
+        if(codec == CompressionCodec::ZSTD){
+            auto * cctx = ZSTD_createCCtx();
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level == 0 ? ZSTD_CLEVEL_DEFAULT : level);
+            // size & dictionary id are in our own header already.
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_contentSizeFlag, 0);
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_dictIDFlag, 0);
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 0);
+            zstd_cctx = cctx;
+        }
+#endif
+    }
+
+    Compressor::~Compressor() {
+#ifdef EZSOCK_WITH_LZ4
+        LZ4_freeStream((LZ4_stream_t *)lz4_stream);
+#endif
+
+#ifdef EZSOCK_WITH_ZSTD
+        ZSTD_freeCCtx((ZSTD_CCtx *)zstd_cctx);
+#endif
+    }
+
+    bool Compressor::is_available(CompressionCodec codec) noexcept {
+        switch(codec){
+        case CompressionCodec::STORE:
+            return true;
+#ifdef EZSOCK_WITH_LZ4
+        case CompressionCodec::LZ4:
+            return true;
+#endif
+#ifdef EZSOCK_WITH_ZSTD
+        case CompressionCodec::ZSTD:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    size_t Compressor::compress_payload(const uint8_t * src, size_t size, uint8_t * dst, size_t capacity) {
+#ifdef EZSOCK_WITH_LZ4
+        if(codec == CompressionCodec::LZ4){
+            auto * stream = (LZ4_stream_t *)lz4_stream;
+            auto acceleration = level <= 0 ? 1 : level;
+            auto res = 0;
+
+            if(dictionary != nullptr){
+                // a copy of the loaded stream instead of loading the dictionary again.
+                std::memcpy(stream, dictionary->lz4_stream, sizeof(LZ4_stream_t));
+                res = LZ4_compress_fast_continue(stream, (const char *)src, (char *)dst, int(size), int(capacity), acceleration);
+            }
+            else res = LZ4_compress_fast_extState(stream, (const char *)src, (char *)dst, int(size), int(capacity), acceleration);
+
+            return res > 0 ? size_t(res) : 0;
+        }
+#endif
+
+#ifdef EZSOCK_WITH_ZSTD
+        if(codec == CompressionCodec::ZSTD){
+            auto * cctx = (ZSTD_CCtx *)zstd_cctx;
+            ZSTD_CCtx_refCDict(cctx, dictionary == nullptr ? nullptr : (const ZSTD_CDict *)dictionary->zstd_cdict);
+
+            auto res = ZSTD_compress2(cctx, dst, capacity, src, size);
+            // output too small is the common error here, and the context must be reset after it.
+            if(ZSTD_isError(res)){
+                ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+                return 0;
+            }
+            return res;
+        }
+#endif
+
+        (void)src, (void)size, (void)dst, (void)capacity;
+        return 0;
+    }
+
+    ssize_t Compressor::compress(const uint8_t * src, size_t size, uint8_t * dst, size_t capacity) {
+        if(size > UINT32_MAX) return -1;
+
+        auto header = CompressionHeader{uint8_t(codec), dictionary == nullptr ? 0 : dictionary->get_id(), uint32_t(size)};
+        auto header_size = CompressionHeaderFormat::get_size(header);
+        auto payload_size = size_t(0);
+
+        // compressed payload has to beat a stored one by 1/16, else it is not worth decompressing.
+        auto is_tried = codec != CompressionCodec::STORE && size >= MIN_COMPRESSED_SIZE && skip_count == 0;
+        if(is_tried && capacity > header_size){
+            auto limit = size - size / 16;
+            payload_size = compress_payload(src, size, dst + header_size, limit < capacity - header_size ? limit : capacity - header_size);
+        }
+
+        if(payload_size != 0){
+            skip_backoff = 0;
+            compressed_count ++;
+        }
+        else{
+            if(skip_count != 0) skip_count --;
+            else if(is_tried){
+                skip_backoff = skip_backoff == 0 ? 1 : (skip_backoff * 2 < MAX_SKIP_BACKOFF ? skip_backoff * 2 : MAX_SKIP_BACKOFF);
+                skip_count = skip_backoff;
+            }
+
+            header = CompressionHeader{uint8_t(CompressionCodec::STORE), 0, uint32_t(size)};
+            header_size = CompressionHeaderFormat::get_size(header);
+            if(capacity < header_size + size) return -1;
+
+            std::memcpy(dst + header_size, src, size);
+            payload_size = size;
+            stored_count ++;
+        }
+
+        CompressionHeaderFormat::encode(header, dst, header_size);
+
+        input_size += size;
+        output_size += header_size + payload_size;
+
+        return ssize_t(header_size + payload_size);
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // Decompressor
+
+    Decompressor::Decompressor() : dictionaries(), zstd_dctx(nullptr) {
+#ifdef EZSOCK_WITH_ZSTD
+        zstd_dctx = ZSTD_createDCtx();
+#endif
+    }
+
+    Decompressor::~Decompressor() {
+#ifdef EZSOCK_WITH_ZSTD
+        ZSTD_freeDCtx((ZSTD_DCtx *)zstd_dctx);
+#endif
+    }
+
+    ssize_t Decompressor::decompress(const uint8_t * src, size_t size, uint8_t * dst, size_t capacity) {
+        auto header = CompressionHeader();
+        auto header_size = CompressionHeaderFormat::decode(src, size, header);
+        if(header_size < 0 || header.original_size > capacity) return -1;
+
+        src += header_size;
+        size -= size_t(header_size);
+
+        const auto * dictionary = (const CompressionDictionary *)nullptr;
+        if(header.dictionary_id != 0){
+            auto iter = dictionaries.find(header.dictionary_id);
+            if(iter == dictionaries.end()) return -1;
+            dictionary = iter->second;
+        }
+
+        switch(CompressionCodec(header.codec)){
+        case CompressionCodec::STORE:
+            if(size != header.original_size) return -1;
+            std::memcpy(dst, src, size);
+            return ssize_t(size);
+
+#ifdef EZSOCK_WITH_LZ4
+        case CompressionCodec::LZ4: {
+            auto res = 0;
+            if(dictionary != nullptr) res = LZ4_decompress_safe_usingDict((const char *)src, (char *)dst, int(size), int(header.original_size), (const char *)dictionary->content.get_buf_base(), int(dictionary->content.get_buf_size()));
+            else res = LZ4_decompress_safe((const char *)src, (char *)dst, int(size), int(header.original_size));
+
+            if(res < 0 || uint32_t(res) != header.original_size) return -1;
+            return ssize_t(res);
+        }
+#endif
+
+#ifdef EZSOCK_WITH_ZSTD
+        case CompressionCodec::ZSTD: {
+            auto * dctx = (ZSTD_DCtx *)zstd_dctx;
+            ZSTD_DCtx_refDDict(dctx, dictionary == nullptr ? nullptr : (const ZSTD_DDict *)dictionary->zstd_ddict);
+
+            auto res = ZSTD_decompressDCtx(dctx, dst, header.original_size, src, size);
+            if(ZSTD_isError(res)){
+                ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+                return -1;
+            }
+            if(res != header.original_size) return -1;
+            return ssize_t(res);
+        }
+#endif
+
+        default:
+            (void)dictionary;
+            return -1;
+        }
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // CompressedSender
+
+    CompressedSender::CompressedSender(UDPSocket & src_socket, CompressionCodec codec, size_t max_chunk_size, int level) : socket(src_socket), compressor(codec, level), datagram(Compressor::get_max_frame_size(max_chunk_size)) {}
+
+    ssize_t CompressedSender::send(const SocketAddress_IPv4 & target, const Buffer & src_buf, size_t size) {
+        auto frame_size = compressor.compress(src_buf, size, datagram);
+        if(frame_size < 0) return -1;
+
+        return socket.send(target, datagram, size_t(frame_size));
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // CompressedReceiver
+
+    CompressedReceiver::CompressedReceiver(UDPSocket & src_socket) : socket(src_socket), decompressor() {}
+
+    ssize_t CompressedReceiver::receive(SocketAddress_IPv4 & target, Buffer & dst_buf) {
+        auto res = ssize_t(-1);
+        while(res < 0){
+            auto size = socket.receive(target);
+            if(size < 0) return -1;
+            res = decompressor.decompress(socket.get_buf_ref_const(), size_t(size), dst_buf);
+        }
+
+        return res;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
\ No newline at end of file
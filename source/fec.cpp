@@ -0,0 +1,586 @@
+/*
+ * @file fec.cpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-12
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#include "fec.hpp"
+#include "udp_socket.hpp"
+#include <cstring>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/* -------------------------------------------------------------------------------- */
+
+// utilities
+
+// GF(2^8) arithmetic with polynomial x^8 + x^4 + x^3 + x^2 + 1.
+static struct GF256 {
+    uint8_t exp[512];
+    uint8_t log[256];
+    uint8_t mul[256][256];
+
+    GF256() {
+        auto x = 1;
+        for(int i = 0; i < 255; i ++){
+            exp[i] = uint8_t(x);
+            exp[i + 255] = uint8_t(x);
+            log[x] = uint8_t(i);
+            x <<= 1;
+            if(x & 0x100) x ^= 0x11d;
+        }
+        exp[510] = exp[0];
+        exp[511] = exp[1];
+        log[0] = 0;
+
+        for(int a = 0; a < 256; a ++){
+            for(int b = 0; b < 256; b ++){
+                mul[a][b] = (a == 0 || b == 0) ? 0 : exp[log[a] + log[b]];
+            }
+        }
+    }
+
+    uint8_t inv(uint8_t a) const noexcept {
+        return exp[255 - log[a]];
+    }
+} gf256;
+
+// to get coefficient of data shard i in parity shard j.
+// rows 255 - j and columns i never collide while k + m <= 256.
+static inline uint8_t cauchy_coefficient(uint8_t j, uint8_t i) noexcept {
+    return gf256.inv(uint8_t(255 - j) ^ i);
+}
+
+// to write FEC header into a datagram.
+static void write_header(uint8_t * dst, EZSock::FECScheme scheme, bool is_parity, uint8_t k, uint8_t m, uint8_t index, uint32_t block_id) noexcept {
+    dst[0] = uint8_t(scheme) | (is_parity ? 0x80 : 0x00);
+    dst[1] = k;
+    dst[2] = m;
+    dst[3] = index;
+    dst[4] = uint8_t(block_id >> 24);
+    dst[5] = uint8_t(block_id >> 16);
+    dst[6] = uint8_t(block_id >> 8);
+    dst[7] = uint8_t(block_id);
+}
+
+// to get payload length stored in front of a shard.
+static inline size_t read_length(const uint8_t * src) noexcept {
+    return (size_t(src[0]) << 8) | size_t(src[1]);
+}
+
+// max number of senders a FECReceiver keeps decoders for.
+static constexpr size_t MAX_FEC_SENDER_COUNT = 256;
+
+// to compute dst ^= src.
+static inline void xor_region(uint8_t * dst, const uint8_t * src, size_t size) noexcept {
+    for(size_t i = 0; i < size; i ++) dst[i] ^= src[i];
+}
+
+// to compute dst ^= c * src from byte i on, by table lookup.
+static inline void mul_region_table(uint8_t * dst, const uint8_t * src, uint8_t c, size_t i, size_t size) noexcept {
+    const auto * row = gf256.mul[c];
+    for(; i < size; i ++) dst[i] ^= row[src[i]];
+}
+
+// to compute dst ^= c * src, one variant per instruction set below.
+using MulRegion = void (*)(uint8_t *, const uint8_t *, uint8_t, size_t) noexcept;
+
+static void mul_region_scalar(uint8_t * dst, const uint8_t * src, uint8_t c, size_t size) noexcept {
+    mul_region_table(dst, src, c, 0, size);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// split multiply : c * x = c * (x & 0x0f) ^ c * (x & 0xf0), 16-entry tables for pshufb.
+static inline void make_split_tables(uint8_t c, uint8_t * table_lo, uint8_t * table_hi) noexcept {
+    for(int n = 0; n < 16; n ++){
+        table_lo[n] = gf256.mul[c][n];
+        table_hi[n] = gf256.mul[c][n << 4];
+    }
+}
+
+__attribute__((target("ssse3")))
+static void mul_region_ssse3(uint8_t * dst, const uint8_t * src, uint8_t c, size_t size) noexcept {
+    alignas(16) uint8_t table_lo[16];
+    alignas(16) uint8_t table_hi[16];
+    make_split_tables(c, table_lo, table_hi);
+
+    auto lo = _mm_load_si128((const __m128i *)table_lo);
+    auto hi = _mm_load_si128((const __m128i *)table_hi);
+    auto mask = _mm_set1_epi8(0x0f);
+    auto i = size_t(0);
+    for(; i + 16 <= size; i += 16){
+        auto s = _mm_loadu_si128((const __m128i *)(src + i));
+        auto l = _mm_shuffle_epi8(lo, _mm_and_si128(s, mask));
+        auto h = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(s, 4), mask));
+        auto d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(d, _mm_xor_si128(l, h)));
+    }
+    mul_region_table(dst, src, c, i, size);
+}
+
+__attribute__((target("avx2")))
+static void mul_region_avx2(uint8_t * dst, const uint8_t * src, uint8_t c, size_t size) noexcept {
+    alignas(16) uint8_t table_lo[16];
+    alignas(16) uint8_t table_hi[16];
+    make_split_tables(c, table_lo, table_hi);
+
+    auto lo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)table_lo));
+    auto hi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)table_hi));
+    auto mask = _mm256_set1_epi8(0x0f);
+    auto i = size_t(0);
+    for(; i + 32 <= size; i += 32){
+        auto s = _mm256_loadu_si256((const __m256i *)(src + i));
+        auto l = _mm256_shuffle_epi8(lo, _mm256_and_si256(s, mask));
+        auto h = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask));
+        auto d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(d, _mm256_xor_si256(l, h)));
+    }
+    mul_region_table(dst, src, c, i, size);
+}
+#endif
+
+// to pick region multiply for the cpu we run on, once.
+static MulRegion select_mul_region() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return mul_region_avx2;
+    if(__builtin_cpu_supports("ssse3")) return mul_region_ssse3;
+#endif
+    return mul_region_scalar;
+}
+
+static const MulRegion mul_region_impl = select_mul_region();
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // ReedSolomonCodec
+
+    void ReedSolomonCodec::mul_add_region(uint8_t * dst, const uint8_t * src, uint8_t c, size_t size) noexcept {
+        if(c == 0) return;
+        if(c == 1){
+            xor_region(dst, src, size);
+            return;
+        }
+
+        mul_region_impl(dst, src, c, size);
+    }
+
+    void ReedSolomonCodec::encode(const uint8_t * const * data, uint8_t * const * parity, size_t size) const noexcept {
+        for(uint8_t j = 0; j < m; j ++){
+            std::memset(parity[j], 0, size);
+            for(uint8_t i = 0; i < k; i ++){
+                mul_add_region(parity[j], data[i], cauchy_coefficient(j, i), size);
+            }
+        }
+    }
+
+    bool ReedSolomonCodec::reconstruct(uint8_t * const * data, const uint8_t * const * parity, const bool * is_present, size_t size) const {
+        auto missing = std::vector<uint8_t>();
+        for(uint8_t i = 0; i < k; i ++){
+            if(!is_present[i]) missing.push_back(i);
+        }
+        if(missing.empty()) return true;
+
+        // pick k surviving shards : present data first, then parity.
+        auto rows = std::vector<const uint8_t *>();
+        auto matrix = std::vector<uint8_t>(size_t(k) * k, 0);
+        for(uint8_t i = 0; i < k; i ++){
+            if(!is_present[i]) continue;
+            matrix[rows.size() * k + i] = 1;
+            rows.push_back(data[i]);
+        }
+        for(uint8_t j = 0; j < m && rows.size() < k; j ++){
+            if(!is_present[k + j]) continue;
+            for(uint8_t i = 0; i < k; i ++) matrix[rows.size() * k + i] = cauchy_coefficient(j, i);
+            rows.push_back(parity[j]);
+        }
+        if(rows.size() < k) return false;
+
+        // gauss-jordan inversion.
+        auto inverse = std::vector<uint8_t>(size_t(k) * k, 0);
+        for(uint8_t i = 0; i < k; i ++) inverse[size_t(i) * k + i] = 1;
+
+        for(size_t col = 0; col < k; col ++){
+            auto pivot = col;
+            while(pivot < k && matrix[pivot * k + col] == 0) pivot ++;
+            if(pivot == k) return false;
+
+            if(pivot != col){
+                for(size_t n = 0; n < k; n ++){
+                    std::swap(matrix[pivot * k + n], matrix[col * k + n]);
+                    std::swap(inverse[pivot * k + n], inverse[col * k + n]);
+                }
+            }
+
+            auto scale = gf256.inv(matrix[col * k + col]);
+            for(size_t n = 0; n < k; n ++){
+                matrix[col * k + n] = gf256.mul[scale][matrix[col * k + n]];
+                inverse[col * k + n] = gf256.mul[scale][inverse[col * k + n]];
+            }
+
+            for(size_t row = 0; row < k; row ++){
+                auto factor = matrix[row * k + col];
+                if(row == col || factor == 0) continue;
+                for(size_t n = 0; n < k; n ++){
+                    matrix[row * k + n] ^= gf256.mul[factor][matrix[col * k + n]];
+                    inverse[row * k + n] ^= gf256.mul[factor][inverse[col * k + n]];
+                }
+            }
+        }
+
+        for(auto i : missing){
+            std::memset(data[i], 0, size);
+            for(size_t row = 0; row < k; row ++){
+                mul_add_region(data[i], rows[row], inverse[size_t(i) * k + row], size);
+            }
+        }
+
+        return true;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // FECEncoder
+
+    FECEncoder::FECEncoder(FECScheme src_scheme, uint8_t src_k, uint8_t src_m, size_t src_max_payload_size) : scheme(src_scheme), k(src_k), m(src_m), max_payload_size(src_max_payload_size), block_id(0), data_count(0), shard_size(0), shards(), datagrams() {
+        if(m == 0) m = 1;
+        if(k == 0) k = 1;
+        if(size_t(k) + m > 256) k = uint8_t(256 - m);
+        if(max_payload_size > 0xffff) max_payload_size = 0xffff;
+
+        shards.resize(k);
+    }
+
+    void FECEncoder::finish_block() {
+        if(data_count == 0) return;
+
+        for(uint8_t i = 0; i < data_count; i ++) shards[i].resize(shard_size, 0);
+
+        auto parity = std::vector<std::vector<uint8_t>>(m, std::vector<uint8_t>(FEC_HEADER_SIZE + shard_size, 0));
+
+        if(scheme == FECScheme::XOR){
+            for(uint8_t i = 0; i < data_count; i ++){
+                xor_region(parity[i % m].data() + FEC_HEADER_SIZE, shards[i].data(), shard_size);
+            }
+        }
+        else{
+            auto data_ptrs = std::vector<const uint8_t *>(data_count);
+            auto parity_ptrs = std::vector<uint8_t *>(m);
+            for(uint8_t i = 0; i < data_count; i ++) data_ptrs[i] = shards[i].data();
+            for(uint8_t j = 0; j < m; j ++) parity_ptrs[j] = parity[j].data() + FEC_HEADER_SIZE;
+
+            ReedSolomonCodec(data_count, m).encode(data_ptrs.data(), parity_ptrs.data(), shard_size);
+        }
+
+        for(uint8_t j = 0; j < m; j ++){
+            // a xor group without any data carries nothing.
+            if(scheme == FECScheme::XOR && j >= data_count) break;
+
+            write_header(parity[j].data(), scheme, true, data_count, m, j, block_id);
+            datagrams.push_back(std::move(parity[j]));
+        }
+
+        block_id ++;
+        data_count = 0;
+        shard_size = 0;
+    }
+
+    ssize_t FECEncoder::push(const uint8_t * src, size_t size) {
+        if(size > max_payload_size) return -1;
+
+        auto & shard = shards[data_count];
+        shard.resize(FEC_LENGTH_SIZE + size);
+        shard[0] = uint8_t(size >> 8);
+        shard[1] = uint8_t(size);
+        if(size > 0) std::memcpy(shard.data() + FEC_LENGTH_SIZE, src, size);
+
+        if(shard.size() > shard_size) shard_size = shard.size();
+
+        auto datagram = std::vector<uint8_t>(FEC_HEADER_SIZE + shard.size());
+        write_header(datagram.data(), scheme, false, k, m, data_count, block_id);
+        std::memcpy(datagram.data() + FEC_HEADER_SIZE, shard.data(), shard.size());
+        datagrams.push_back(std::move(datagram));
+
+        data_count ++;
+        if(data_count == k) finish_block();
+
+        return ssize_t(size);
+    }
+
+    void FECEncoder::flush() {
+        finish_block();
+    }
+
+    ssize_t FECEncoder::pop(Buffer & dst_buf) {
+        if(datagrams.empty()) return -1;
+
+        auto & datagram = datagrams.front();
+        auto size = datagram.size() < dst_buf.get_buf_size() ? datagram.size() : dst_buf.get_buf_size();
+        std::memcpy(dst_buf.get_buf_base(), datagram.data(), size);
+        datagrams.pop_front();
+
+        return ssize_t(size);
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // FECDecoder
+
+    FECDecoder::FECDecoder(size_t src_window) : window(src_window == 0 ? 1 : src_window), blocks(), newest_block_id(0), payloads() {}
+
+    void FECDecoder::deliver(FECBlock & block, uint8_t index) {
+        auto & shard = block.shards[index];
+        block.is_delivered[index] = true;
+
+        if(shard.size() < FEC_LENGTH_SIZE) return;
+        auto size = read_length(shard.data());
+        if(FEC_LENGTH_SIZE + size > shard.size()) return;
+
+        payloads.emplace_back(shard.begin() + FEC_LENGTH_SIZE, shard.begin() + FEC_LENGTH_SIZE + size);
+    }
+
+    void FECDecoder::try_repair(FECBlock & block) {
+        if(block.is_done) return;
+
+        // parity size is known once any parity arrived, no repair possible before.
+        if(block.shard_size != 0) repair(block);
+
+        auto is_complete = true;
+        for(uint8_t i = 0; i < block.k; i ++) is_complete = is_complete && block.is_delivered[i];
+        if(is_complete){
+            block.is_done = true;
+            block.shards.clear();
+        }
+    }
+
+    void FECDecoder::repair(FECBlock & block) {
+        auto parity_base = block.shards.size() - block.m;
+
+        if(block.scheme == FECScheme::XOR){
+            for(uint8_t j = 0; j < block.m; j ++){
+                if(!block.is_present[parity_base + j]) continue;
+
+                auto missing_count = 0;
+                auto missing = uint8_t(0);
+                for(auto i = j; i < block.k; i += block.m){
+                    if(block.is_present[i]) continue;
+                    missing_count ++;
+                    missing = i;
+                }
+                if(missing_count != 1) continue;
+
+                auto rebuilt = block.shards[parity_base + j];
+                for(auto i = j; i < block.k; i += block.m){
+                    if(i != missing) xor_region(rebuilt.data(), block.shards[i].data(), block.shards[i].size());
+                }
+
+                block.shards[missing] = std::move(rebuilt);
+                block.is_present[missing] = true;
+                block.present_count ++;
+                deliver(block, missing);
+            }
+        }
+        else{
+            if(block.present_count < block.k) return;
+
+            auto data_ptrs = std::vector<uint8_t *>(block.k);
+            auto parity_ptrs = std::vector<const uint8_t *>(block.m);
+            auto is_present = std::unique_ptr<bool[]>(new bool[size_t(block.k) + block.m]);
+            for(uint8_t i = 0; i < block.k; i ++){
+                block.shards[i].resize(block.shard_size, 0);
+                data_ptrs[i] = block.shards[i].data();
+                is_present[i] = block.is_present[i];
+            }
+            for(uint8_t j = 0; j < block.m; j ++){
+                parity_ptrs[j] = block.shards[parity_base + j].data();
+                is_present[block.k + j] = block.is_present[parity_base + j];
+            }
+
+            if(!ReedSolomonCodec(block.k, block.m).reconstruct(data_ptrs.data(), parity_ptrs.data(), is_present.get(), block.shard_size)) return;
+
+            for(uint8_t i = 0; i < block.k; i ++){
+                if(block.is_delivered[i]) continue;
+                block.is_present[i] = true;
+                block.present_count ++;
+                deliver(block, i);
+            }
+        }
+    }
+
+    ssize_t FECDecoder::push(const uint8_t * src, size_t size) {
+        if(size < FEC_HEADER_SIZE + FEC_LENGTH_SIZE) return -1;
+
+        auto scheme = FECScheme(src[0] & 0x7f);
+        auto is_parity = (src[0] & 0x80) != 0;
+        auto k = src[1];
+        auto m = src[2];
+        auto index = src[3];
+        auto block_id = (uint32_t(src[4]) << 24) | (uint32_t(src[5]) << 16) | (uint32_t(src[6]) << 8) | uint32_t(src[7]);
+
+        if(scheme != FECScheme::XOR && scheme != FECScheme::REED_SOLOMON) return -1;
+        if(k == 0 || m == 0 || size_t(k) + m > 256) return -1;
+        if(is_parity ? index >= m : index >= k) return -1;
+
+        const auto * body = src + FEC_HEADER_SIZE;
+        auto body_size = size - FEC_HEADER_SIZE;
+        if(!is_parity && FEC_LENGTH_SIZE + read_length(body) > body_size) return -1;
+
+        auto iter = blocks.find(block_id);
+        if(iter == blocks.end()){
+            auto distance = blocks.empty() ? int64_t(0) : int64_t(int32_t(block_id - newest_block_id));
+            if(distance < 0 && uint64_t(-distance) >= window){
+                // up to one more window behind is a late datagram of a forgotten block (may have been repaired already).
+                // farther behind is a sender that restarted : start over.
+                if(uint64_t(-distance) < window * 2) return ssize_t(size);
+                blocks.clear();
+                distance = 0;
+            }
+
+            // keep only a window of recent blocks.
+            if(blocks.empty() || distance > 0){
+                newest_block_id = block_id;
+                for(auto old_iter = blocks.begin(); old_iter != blocks.end();){
+                    if(uint32_t(block_id - old_iter->first) >= window) old_iter = blocks.erase(old_iter);
+                    else old_iter ++;
+                }
+            }
+
+            auto block = FECBlock{scheme, k, m, 0, 0, 0, false, {}, {}, {}};
+            block.shards.resize(size_t(k) + m);
+            block.is_present.resize(size_t(k) + m, false);
+            block.is_delivered.resize(k, false);
+            iter = blocks.emplace(block_id, std::move(block)).first;
+        }
+
+        auto & block = iter->second;
+        if(block.is_done) return ssize_t(size);
+
+        // every datagram of a block has the same layout, anything else is from another stream or forged.
+        if(scheme != block.scheme || m != block.m) return -1;
+        if(is_parity){
+            // k only shrinks, and only until the first parity fixed it.
+            if(k > block.k || (block.shard_size != 0 && (k != block.k || body_size != block.shard_size))) return -1;
+            if(block.data_k != 0 && k > block.data_k) return -1;
+            for(uint8_t i = 0; i < block.k; i ++){
+                if(!block.is_present[i]) continue;
+                if(i >= k || block.shards[i].size() > body_size) return -1;
+            }
+        }
+        else{
+            if((block.data_k != 0 && k != block.data_k) || k < block.k) return -1;
+            if(block.shard_size != 0 && body_size > block.shard_size) return -1;
+            block.data_k = k;
+        }
+
+        // parity of a partial block carries the real k, data shards beyond it never exist.
+        if(is_parity && k < block.k){
+            auto parity_base = block.shards.size() - block.m;
+            for(uint8_t j = 0; j < block.m; j ++){
+                block.shards[size_t(k) + j] = std::move(block.shards[parity_base + j]);
+                block.is_present[size_t(k) + j] = block.is_present[parity_base + j];
+            }
+            block.k = k;
+            block.shards.resize(size_t(k) + block.m);
+            block.is_present.resize(size_t(k) + block.m);
+            block.is_delivered.resize(k);
+        }
+
+        if(!is_parity && index >= block.k) return ssize_t(size);
+
+        auto slot = is_parity ? size_t(block.k) + index : size_t(index);
+        if(block.is_present[slot]) return ssize_t(size);
+
+        block.shards[slot].assign(body, body + body_size);
+        block.is_present[slot] = true;
+        block.present_count ++;
+
+        if(is_parity) block.shard_size = body_size;
+        else deliver(block, index);
+
+        try_repair(block);
+
+        return ssize_t(size);
+    }
+
+    ssize_t FECDecoder::pop(Buffer & dst_buf) {
+        if(payloads.empty()) return -1;
+
+        auto & payload = payloads.front();
+        auto size = payload.size() < dst_buf.get_buf_size() ? payload.size() : dst_buf.get_buf_size();
+        if(size > 0) std::memcpy(dst_buf.get_buf_base(), payload.data(), size);
+        payloads.pop_front();
+
+        return ssize_t(size);
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // FECSender
+
+    FECSender::FECSender(UDPSocket & src_socket, FECScheme scheme, uint8_t k, uint8_t m, size_t max_payload_size) : socket(src_socket), encoder(scheme, k, m, max_payload_size), datagram(encoder.get_max_datagram_size()) {}
+
+    ssize_t FECSender::send_queued(const SocketAddress_IPv4 & target) {
+        auto size = ssize_t(0);
+        while((size = encoder.pop(datagram)) >= 0){
+            if(socket.send(target, datagram, size_t(size)) < 0) return -1;
+        }
+        return 0;
+    }
+
+    ssize_t FECSender::send(const SocketAddress_IPv4 & target, const Buffer & src_buf, size_t size) {
+        auto res = encoder.push(src_buf, size);
+        if(res < 0) return -1;
+        if(send_queued(target) < 0) return -1;
+
+        return res;
+    }
+
+    ssize_t FECSender::flush(const SocketAddress_IPv4 & target) {
+        encoder.flush();
+        return send_queued(target);
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // FECReceiver
+
+    FECReceiver::FECReceiver(UDPSocket & src_socket, size_t src_window) : socket(src_socket), window(src_window), decoders(), last_decoder(nullptr), last_source() {}
+
+    ssize_t FECReceiver::receive(SocketAddress_IPv4 & target, Buffer & dst_buf) {
+        auto res = ssize_t(0);
+        while(last_decoder == nullptr || (res = last_decoder->pop(dst_buf)) < 0){
+            auto size = socket.receive(last_source);
+            if(size < 0) return -1;
+
+            auto key = std::make_pair(last_source.get_ipv4_address().get(), last_source.get_ipv4_port());
+            auto iter = decoders.find(key);
+            if(iter == decoders.end()){
+                // forget an arbitrary sender rather than grow without bound.
+                if(decoders.size() >= MAX_FEC_SENDER_COUNT) decoders.erase(decoders.begin());
+                iter = decoders.emplace(key, FECDecoder(window)).first;
+            }
+
+            last_decoder = &iter->second;
+            last_decoder->push(socket.get_buf_ref_const(), size_t(size));
+        }
+
+        target = last_source;
+        return res;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
\ No newline at end of file
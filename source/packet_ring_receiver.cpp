@@ -0,0 +1,193 @@
+/*
+ * @file packet_ring_receiver.cpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-22
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#include "packet_ring_receiver.hpp"
+#include <linux/if_ether.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <iostream>
+
+/* -------------------------------------------------------------------------------- */
+
+// utilities
+
+// to read a big endian 16-bit integer.
+static inline uint16_t read_u16(const uint8_t * src) noexcept {
+    return uint16_t((uint16_t(src[0]) << 8) | uint16_t(src[1]));
+}
+
+// to read a big endian 32-bit integer.
+static inline uint32_t read_u32(const uint8_t * src) noexcept {
+    return (uint32_t(src[0]) << 24) | (uint32_t(src[1]) << 16) | (uint32_t(src[2]) << 8) | uint32_t(src[3]);
+}
+
+// sizes of fixed headers.
+static constexpr size_t IPV4_HEADER_MIN_SIZE = 20;
+static constexpr size_t UDP_HEADER_SIZE = 8;
+static constexpr uint8_t IPPROTO_UDP_NUMBER = 17;
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketRingReceiver
+
+    int PacketRingReceiver::open(const char * interface_name) {
+        if(is_active) return -1;
+
+        auto interface_index = ::if_nametoindex(interface_name);
+        if(interface_index == 0) return -1;
+
+        // protocol 0 captures nothing until bind, so no frame of another interface lands in the ring first.
+        auto fd = ::socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, 0);
+        if(fd < 0) return -1;
+
+        auto version = int(TPACKET_V3);
+        auto req = tpacket_req3();
+        req.tp_block_size = (unsigned int)block_size;
+        req.tp_block_nr = (unsigned int)block_count;
+        // frames are variable sized in V3, frame size only has to divide block size.
+        req.tp_frame_size = TPACKET_ALIGNMENT << 7;
+        req.tp_frame_nr = (unsigned int)(block_size / req.tp_frame_size * block_count);
+        req.tp_retire_blk_tov = retire_timeout;
+        req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
+        if(::setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(int)) < 0 || ::setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(tpacket_req3)) < 0){
+            ::close(fd);
+            return -1;
+        }
+
+        auto * base = ::mmap(nullptr, block_size * block_count, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, fd, 0);
+        // locking may exceed RLIMIT_MEMLOCK, fall back to a plain mapping.
+        if(base == MAP_FAILED) base = ::mmap(nullptr, block_size * block_count, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(base == MAP_FAILED){
+            ::close(fd);
+            return -1;
+        }
+
+        auto sockaddr_ll_tmp = sockaddr_ll();
+        sockaddr_ll_tmp.sll_family = AF_PACKET;
+        sockaddr_ll_tmp.sll_protocol = htons(ETH_P_IP);
+        sockaddr_ll_tmp.sll_ifindex = int(interface_index);
+        if(::bind(fd, (sockaddr *)&sockaddr_ll_tmp, sizeof(sockaddr_ll)) < 0){
+            ::munmap(base, block_size * block_count);
+            ::close(fd);
+            return -1;
+        }
+
+        socket = fd;
+        ring_base = (uint8_t *)base;
+        block_index = 0;
+        is_active = true;
+
+        return 0;
+    }
+
+    int PacketRingReceiver::join_fanout(uint16_t group_id, PacketFanoutMode mode) {
+        if(!is_active) return -1;
+
+        auto fanout = int(uint32_t(group_id) | (uint32_t(mode) << 16));
+        return ::setsockopt(socket, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(int));
+    }
+
+    int PacketRingReceiver::close() {
+        if(!is_active) return -1;
+
+        ::munmap(ring_base, block_size * block_count);
+        auto res = ::close(socket);
+
+        socket = -1;
+        ring_base = nullptr;
+        is_active = false;
+
+        return res;
+    }
+
+    tpacket_block_desc * PacketRingReceiver::next_block(int timeout) {
+        auto * block = (tpacket_block_desc *)(ring_base + block_index * block_size);
+
+        while((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0){
+            auto pollfd_tmp = pollfd{socket, POLLIN | POLLERR, 0};
+            auto res = ::poll(&pollfd_tmp, 1, timeout);
+            if(res < 0 && errno == EINTR) continue;
+            if(res <= 0) return nullptr;
+        }
+
+        block_index = (block_index + 1) % block_count;
+
+        return block;
+    }
+
+    void PacketRingReceiver::release_block(tpacket_block_desc * block) noexcept {
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    }
+
+    bool PacketRingReceiver::parse(const tpacket3_hdr * frame, UDPPacketView & view) const noexcept {
+        const auto * link = (const sockaddr_ll *)((const uint8_t *)frame + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+        if(!is_outgoing_included && link->sll_pkttype == PACKET_OUTGOING) return false;
+
+        // network header offset is independent of link layer type.
+        if(frame->tp_net < frame->tp_mac) return false;
+        auto link_header_size = size_t(frame->tp_net) - frame->tp_mac;
+        if(size_t(frame->tp_snaplen) < link_header_size) return false;
+        const auto * ip = (const uint8_t *)frame + frame->tp_net;
+        auto captured = size_t(frame->tp_snaplen) - link_header_size;
+        if(captured < IPV4_HEADER_MIN_SIZE) return false;
+
+        auto ip_header_size = size_t(ip[0] & 0x0f) * 4;
+        if((ip[0] >> 4) != 4 || ip_header_size < IPV4_HEADER_MIN_SIZE || ip[9] != IPPROTO_UDP_NUMBER) return false;
+        // fragments (other than whole datagrams) do not carry a complete UDP datagram.
+        if((read_u16(ip + 6) & 0x3fff) != 0) return false;
+        if(captured < ip_header_size + UDP_HEADER_SIZE) return false;
+
+        const auto * udp = ip + ip_header_size;
+        auto udp_size = size_t(read_u16(udp + 4));
+        if(udp_size < UDP_HEADER_SIZE) return false;
+
+        auto payload_size = udp_size - UDP_HEADER_SIZE;
+        auto payload_captured = captured - ip_header_size - UDP_HEADER_SIZE;
+
+        view.source = SocketAddress_IPv4(IPv4_Address(read_u32(ip + 12)), read_u16(udp));
+        view.destination = SocketAddress_IPv4(IPv4_Address(read_u32(ip + 16)), read_u16(udp + 2));
+        view.payload = udp + UDP_HEADER_SIZE;
+        view.payload_size = payload_size < payload_captured ? payload_size : payload_captured;
+        view.timestamp_sec = frame->tp_sec;
+        view.timestamp_nsec = frame->tp_nsec;
+
+        return true;
+    }
+
+    int64_t PacketRingReceiver::get_drop_count() const {
+        if(!is_active) return -1;
+
+        auto stats = tpacket_stats_v3();
+        auto socklen_tmp = socklen_t(sizeof(tpacket_stats_v3));
+        if(::getsockopt(socket, SOL_PACKET, PACKET_STATISTICS, &stats, &socklen_tmp) < 0) return -1;
+
+        return int64_t(stats.tp_drops);
+    }
+
+    std::ostream & operator<<(std::ostream & ost, const PacketRingReceiver & packet_ring_receiver) {
+        ost << packet_ring_receiver.socket << " - PACKET ring " << packet_ring_receiver.block_count << " * " << packet_ring_receiver.block_size << " , ";
+
+        if(packet_ring_receiver.is_active) return ost << "active";
+        return ost << "closed";
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
\ No newline at end of file
@@ -0,0 +1,402 @@
+/*
+ * @file packet_trace.cpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-29
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#include "packet_trace.hpp"
+#include "udp_socket.hpp"
+#include "wire_format.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+/* -------------------------------------------------------------------------------- */
+
+// utilities
+
+// header at the beginning of a trace file.
+struct TraceFileHeader {
+    std::array<uint8_t, 8> magic;
+    uint32_t version;
+    uint32_t reserved;
+};
+
+using TraceFileHeaderFormat = EZSock::WireFormat<
+    EZSock::WireField<&TraceFileHeader::magic>,
+    EZSock::WireField<&TraceFileHeader::version>,
+    EZSock::WireField<&TraceFileHeader::reserved>
+>;
+
+// header in front of every payload.
+struct TraceRecordHeader {
+    uint64_t timestamp;
+    uint32_t ip;
+    uint16_t port;
+    uint16_t payload_size;
+};
+
+using TraceRecordHeaderFormat = EZSock::WireFormat<
+    EZSock::WireField<&TraceRecordHeader::timestamp>,
+    EZSock::WireField<&TraceRecordHeader::ip>,
+    EZSock::WireField<&TraceRecordHeader::port>,
+    EZSock::WireField<&TraceRecordHeader::payload_size>
+>;
+
+static_assert(TraceFileHeaderFormat::MAX_SIZE == PACKET_TRACE_HEADER_SIZE, "PACKET_TRACE_HEADER_SIZE is out of date");
+static_assert(TraceRecordHeaderFormat::MAX_SIZE == PACKET_TRACE_RECORD_HEADER_SIZE, "PACKET_TRACE_RECORD_HEADER_SIZE is out of date");
+
+static constexpr std::array<uint8_t, 8> TRACE_MAGIC = {'E', 'Z', 'S', 'T', 'R', 'A', 'C', 'E'};
+
+// to get size of a record in file, padded to 8 bytes.
+static inline size_t get_record_size(size_t payload_size) noexcept {
+    return (PACKET_TRACE_RECORD_HEADER_SIZE + payload_size + 7) & ~size_t(7);
+}
+
+// to get monotonic time in ns.
+static inline uint64_t get_monotonic_now() noexcept {
+    auto timespec_tmp = timespec();
+    ::clock_gettime(CLOCK_MONOTONIC, &timespec_tmp);
+    return uint64_t(timespec_tmp.tv_sec) * 1000000000 + uint64_t(timespec_tmp.tv_nsec);
+}
+
+// to wait until a monotonic deadline in ns, sleeping while it is far and spinning at last.
+static inline uint64_t wait_until(uint64_t deadline) noexcept {
+    static constexpr uint64_t SPIN_TIME = 50000;
+
+    auto now = get_monotonic_now();
+    if(now + SPIN_TIME < deadline){
+        auto wake_up = deadline - SPIN_TIME;
+        auto timespec_tmp = timespec{time_t(wake_up / 1000000000), long(wake_up % 1000000000)};
+        while(::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &timespec_tmp, nullptr) == EINTR);
+        now = get_monotonic_now();
+    }
+    while(now < deadline) now = get_monotonic_now();
+
+    return now;
+}
+
+// to write all bytes, retrying on partial writes.
+static inline bool write_all(int fd, const uint8_t * src, size_t size) noexcept {
+    while(size > 0){
+        auto res = ::write(fd, src, size);
+        if(res < 0){
+            if(errno == EINTR) continue;
+            return false;
+        }
+        src += res;
+        size -= size_t(res);
+    }
+    return true;
+}
+
+// max number of datagrams per sendmmsg() while replaying.
+static constexpr size_t REPLAY_BATCH_SIZE = 1024;
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketTraceRecorder
+
+    PacketTraceRecorder::PacketTraceRecorder(size_t chunk_size, size_t chunk_count) : file(-1), chunks(), chunk_index(0), chunk_pos(0), mutex(), condition(), free_chunks(), full_chunks(), writer(), record_count(0), drop_count(0), is_write_failed(false), is_active(false), is_stopping(false) {
+        if(chunk_count < 2) chunk_count = 2;
+
+        chunks.reserve(chunk_count);
+        for(size_t i = 0; i < chunk_count; i ++) chunks.emplace_back(chunk_size);
+    }
+
+    int PacketTraceRecorder::open(const char * path) {
+        if(is_active) return -1;
+
+        auto fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0) return -1;
+
+        auto header = TraceFileHeader{TRACE_MAGIC, PACKET_TRACE_VERSION, 0};
+        uint8_t header_bytes[PACKET_TRACE_HEADER_SIZE];
+        TraceFileHeaderFormat::encode(header, header_bytes, PACKET_TRACE_HEADER_SIZE);
+        if(!write_all(fd, header_bytes, PACKET_TRACE_HEADER_SIZE)){
+            ::close(fd);
+            return -1;
+        }
+
+        file = fd;
+        chunk_index = 0;
+        chunk_pos = 0;
+        free_chunks.clear();
+        full_chunks.clear();
+        for(size_t i = 1; i < chunks.size(); i ++) free_chunks.push_back(i);
+
+        record_count = 0;
+        drop_count = 0;
+        is_write_failed = false;
+        is_stopping = false;
+        is_active = true;
+
+        writer = std::thread(&PacketTraceRecorder::write_chunks, this);
+
+        return 0;
+    }
+
+    int PacketTraceRecorder::close() {
+        if(!is_active) return -1;
+
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex);
+            // no chunk is needed after this one, so queue it even if none is free (swap_chunk() would refuse).
+            if(chunk_pos != 0) full_chunks.emplace_back(chunk_index, chunk_pos);
+            chunk_pos = 0;
+            is_stopping = true;
+        }
+        condition.notify_one();
+        writer.join();
+
+        auto res = ::close(file);
+        file = -1;
+        is_active = false;
+
+        return is_write_failed ? -1 : res;
+    }
+
+    void PacketTraceRecorder::write_chunks() {
+        auto lock = std::unique_lock<std::mutex>(mutex);
+
+        while(true){
+            condition.wait(lock, [this] { return !full_chunks.empty() || is_stopping; });
+            if(full_chunks.empty()) return;
+
+            auto chunk = full_chunks.front();
+            full_chunks.pop_front();
+
+            lock.unlock();
+            if(!is_write_failed && !write_all(file, chunks[chunk.first].get_buf_base(), chunk.second)) is_write_failed = true;
+            lock.lock();
+
+            free_chunks.push_back(chunk.first);
+        }
+    }
+
+    bool PacketTraceRecorder::swap_chunk() {
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex);
+            if(free_chunks.empty()) return false;
+
+            full_chunks.emplace_back(chunk_index, chunk_pos);
+            chunk_index = free_chunks.back();
+            free_chunks.pop_back();
+        }
+        condition.notify_one();
+
+        chunk_pos = 0;
+        return true;
+    }
+
+    int PacketTraceRecorder::record(uint64_t timestamp, const SocketAddress_IPv4 & source, const uint8_t * payload, size_t payload_size) {
+        if(!is_active) return -1;
+
+        auto record_size = get_record_size(payload_size);
+        auto & chunk = chunks[chunk_index];
+        if(payload_size > UINT16_MAX || record_size > chunk.get_buf_size() || is_write_failed){
+            drop_count ++;
+            return -1;
+        }
+        // writer is behind, keep the full chunk and try again on next record.
+        if(chunk_pos + record_size > chunk.get_buf_size() && !swap_chunk()){
+            drop_count ++;
+            return -1;
+        }
+
+        auto * dst = chunks[chunk_index].get_buf_base() + chunk_pos;
+        auto header = TraceRecordHeader{timestamp, source.get_ipv4_address().get(), source.get_ipv4_port(), uint16_t(payload_size)};
+        TraceRecordHeaderFormat::encode(header, dst, PACKET_TRACE_RECORD_HEADER_SIZE);
+        if(payload_size != 0) std::memcpy(dst + PACKET_TRACE_RECORD_HEADER_SIZE, payload, payload_size);
+        // padding is zeroed, so files are reproducible.
+        std::memset(dst + PACKET_TRACE_RECORD_HEADER_SIZE + payload_size, 0, record_size - PACKET_TRACE_RECORD_HEADER_SIZE - payload_size);
+
+        chunk_pos += record_size;
+        record_count ++;
+
+        return 0;
+    }
+
+    int PacketTraceRecorder::record(const SocketAddress_IPv4 & source, const Buffer & src_buf, size_t size) {
+        if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+        return record(get_now(), source, src_buf.get_buf_base(), size);
+    }
+
+    ssize_t PacketTraceRecorder::receive(const UDPSocket & socket, SocketAddress_IPv4 & target) {
+        auto res = socket.receive(target);
+        if(res >= 0) record(target, socket.get_buf_ref_const(), size_t(res));
+
+        return res;
+    }
+
+    void PacketTraceRecorder::flush() {
+        if(!is_active || chunk_pos == 0) return;
+        swap_chunk();
+    }
+
+    uint64_t PacketTraceRecorder::get_now() noexcept {
+        auto timespec_tmp = timespec();
+        ::clock_gettime(CLOCK_REALTIME, &timespec_tmp);
+        return uint64_t(timespec_tmp.tv_sec) * 1000000000 + uint64_t(timespec_tmp.tv_nsec);
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketTraceReader
+
+    int PacketTraceReader::open(const char * path) {
+        if(is_active) return -1;
+
+        auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if(fd < 0) return -1;
+
+        struct stat stat_tmp{};
+        if(::fstat(fd, &stat_tmp) < 0 || size_t(stat_tmp.st_size) < PACKET_TRACE_HEADER_SIZE){
+            ::close(fd);
+            return -1;
+        }
+
+        auto size = size_t(stat_tmp.st_size);
+        auto * base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(base == MAP_FAILED) return -1;
+
+        auto header = TraceFileHeader();
+        TraceFileHeaderFormat::decode((const uint8_t *)base, size, header);
+        if(header.magic != TRACE_MAGIC || header.version != PACKET_TRACE_VERSION){
+            ::munmap(base, size);
+            return -1;
+        }
+
+        // records are read front to back once.
+        ::madvise(base, size, MADV_SEQUENTIAL);
+
+        file_base = (const uint8_t *)base;
+        file_size = size;
+        pos = PACKET_TRACE_HEADER_SIZE;
+        is_active = true;
+
+        return 0;
+    }
+
+    int PacketTraceReader::close() {
+        if(!is_active) return -1;
+
+        auto res = ::munmap((void *)file_base, file_size);
+        file_base = nullptr;
+        file_size = 0;
+        is_active = false;
+
+        return res;
+    }
+
+    bool PacketTraceReader::next(PacketTraceRecord & record) noexcept {
+        if(!is_active) return false;
+
+        auto header = TraceRecordHeader();
+        if(TraceRecordHeaderFormat::decode(file_base + pos, file_size - pos, header) < 0) return false;
+        if(file_size - pos - PACKET_TRACE_RECORD_HEADER_SIZE < header.payload_size) return false;
+
+        record.timestamp = header.timestamp;
+        record.source = SocketAddress_IPv4(IPv4_Address(header.ip), header.port);
+        record.payload = file_base + pos + PACKET_TRACE_RECORD_HEADER_SIZE;
+        record.payload_size = header.payload_size;
+
+        auto record_size = get_record_size(header.payload_size);
+        pos = record_size < file_size - pos ? pos + record_size : file_size;
+
+        return true;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // PacketTraceReplayer
+
+    PacketTraceReplayer::PacketTraceReplayer(UDPSocket & src_socket) : socket(src_socket), sent_count(0), max_lateness(0), total_lateness(0), batch_count(0) {}
+
+    ssize_t PacketTraceReplayer::replay(PacketTraceReader & reader, const SocketAddress_IPv4 & target, double speed) {
+        if(!socket.get_status() || !reader.get_status()) return -1;
+
+        auto record = PacketTraceRecord();
+        if(!reader.next(record)) return 0;
+
+        // every message goes to the same target, payloads are sent straight from the mapped file.
+        auto sockaddr_in_tmp = sockaddr_in();
+        sockaddr_in_tmp.sin_family = AF_INET;
+        sockaddr_in_tmp.sin_addr.s_addr = htonl(target.get_ipv4_address().get());
+        sockaddr_in_tmp.sin_port = htons(target.get_ipv4_port());
+        auto iovecs = std::vector<iovec>(REPLAY_BATCH_SIZE);
+        auto mmsghdrs = std::vector<mmsghdr>(REPLAY_BATCH_SIZE);
+        for(size_t i = 0; i < REPLAY_BATCH_SIZE; i ++){
+            mmsghdrs[i].msg_hdr.msg_name = &sockaddr_in_tmp;
+            mmsghdrs[i].msg_hdr.msg_namelen = socklen_t(sizeof(sockaddr_in));
+            mmsghdrs[i].msg_hdr.msg_iov = &iovecs[i];
+            mmsghdrs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        auto first_timestamp = record.get_timestamp();
+        auto start = get_monotonic_now();
+        auto sent = size_t(0);
+        auto is_remaining = true;
+
+        // to get when a record is due on monotonic clock.
+        auto get_deadline = [&](const PacketTraceRecord & src_record) {
+            if(speed <= 0 || src_record.get_timestamp() <= first_timestamp) return start;
+            return start + uint64_t(double(src_record.get_timestamp() - first_timestamp) / speed);
+        };
+
+        while(is_remaining){
+            auto deadline = get_deadline(record);
+            auto now = wait_until(deadline);
+
+            // there is no schedule at full speed.
+            if(speed > 0){
+                auto lateness = now - deadline;
+                if(lateness > max_lateness) max_lateness = lateness;
+                total_lateness += lateness;
+                batch_count ++;
+            }
+
+            // take every record due by now.
+            auto count = size_t(0);
+            do{
+                iovecs[count] = iovec{(void *)record.get_payload(), record.get_payload_size()};
+                count ++;
+                is_remaining = reader.next(record);
+            }while(is_remaining && count < REPLAY_BATCH_SIZE && get_deadline(record) <= now);
+
+            auto done = size_t(0);
+            while(done < count){
+                auto res = ::sendmmsg(socket.get_socket(), mmsghdrs.data() + done, (unsigned int)(count - done), 0);
+                if(res < 0){
+                    if(errno == EINTR) continue;
+                    sent_count += sent;
+                    return sent == 0 ? -1 : ssize_t(sent);
+                }
+                done += size_t(res);
+                sent += size_t(res);
+            }
+        }
+
+        sent_count += sent;
+        return ssize_t(sent);
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
\ No newline at end of file
@@ -0,0 +1,290 @@
+/*
+ * @file shared_memory_socket.cpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-19
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#include "shared_memory_socket.hpp"
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+/* -------------------------------------------------------------------------------- */
+
+// utilities
+
+// "EZSKSHM1"
+static constexpr uint64_t SHM_MAGIC = 0x314d48534b535a45;
+// number of polls before an empty ring is slept on, spinning on a single cpu only delays the peer.
+static const int SPIN_LIMIT = std::thread::hardware_concurrency() > 1 ? 4096 : 0;
+
+// control block of one direction, head & tail on separate cache lines.
+struct ShmRingControl {
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> is_waiting;
+};
+
+// layout at the start of memfd, followed by slots of ring 0 and ring 1.
+// ring 0 carries peer 0 -> peer 1, ring 1 carries peer 1 -> peer 0.
+struct ShmHeader {
+    uint64_t magic;
+    uint64_t slot_size;
+    uint64_t slot_count;
+    ShmRingControl rings[2];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory rings need lock free atomics");
+
+// to round up to a multiple of cache line.
+static inline size_t align_cache_line(size_t size) noexcept {
+    return (size + 63) & ~size_t(63);
+}
+
+// to get distance between two slots : length field & data.
+static inline size_t get_slot_stride(size_t slot_size) noexcept {
+    return align_cache_line(sizeof(uint64_t) + slot_size);
+}
+
+// to get address of a slot.
+static inline uint8_t * get_slot(uint8_t * base, const ShmHeader * header, uint32_t ring, uint64_t index) noexcept {
+    auto stride = get_slot_stride(header->slot_size);
+    return base + align_cache_line(sizeof(ShmHeader)) + (ring * header->slot_count + (index & (header->slot_count - 1))) * stride;
+}
+
+static inline void futex_wait(std::atomic<uint32_t> * address, uint32_t value) noexcept {
+    ::syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT, value, nullptr, nullptr, 0);
+}
+
+static inline void futex_wake(std::atomic<uint32_t> * address) noexcept {
+    ::syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+static inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // SharedMemoryPeer
+
+    std::ostream & operator<<(std::ostream & ost, const SharedMemoryPeer & shared_memory_peer) {
+        return ost << "SHM@" << shared_memory_peer.peer_id;
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+    // SharedMemorySocket
+
+    int SharedMemorySocket::map(int fd, bool is_creator) {
+        struct stat stat_tmp{};
+        if(::fstat(fd, &stat_tmp) < 0 || size_t(stat_tmp.st_size) < sizeof(ShmHeader)) return -1;
+
+        auto size = size_t(stat_tmp.st_size);
+        auto * base = (uint8_t *)::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(base == MAP_FAILED) return -1;
+
+        if(!is_creator){
+            const auto * header = (const ShmHeader *)base;
+            auto expected_size = align_cache_line(sizeof(ShmHeader)) + 2 * header->slot_count * get_slot_stride(header->slot_size);
+            auto is_power_of_2 = header->slot_count != 0 && (header->slot_count & (header->slot_count - 1)) == 0;
+            if(header->magic != SHM_MAGIC || !is_power_of_2 || expected_size > size){
+                ::munmap(base, size);
+                return -1;
+            }
+        }
+
+        shm_fd = fd;
+        shm_base = base;
+        shm_size = size;
+        is_active = true;
+
+        return 0;
+    }
+
+    int SharedMemorySocket::create(size_t slot_count) {
+        if(is_active) return -1;
+
+        auto rounded_slot_count = size_t(1);
+        while(rounded_slot_count < slot_count) rounded_slot_count <<= 1;
+
+        auto slot_size = buffer.get_buf_size();
+        auto size = align_cache_line(sizeof(ShmHeader)) + 2 * rounded_slot_count * get_slot_stride(slot_size);
+
+        auto fd = ::memfd_create("ezsock-shm-ring", MFD_CLOEXEC);
+        if(fd < 0) return -1;
+        if(::ftruncate(fd, off_t(size)) < 0 || map(fd, true) < 0){
+            ::close(fd);
+            return -1;
+        }
+
+        auto * header = new (shm_base) ShmHeader();
+        header->slot_size = slot_size;
+        header->slot_count = rounded_slot_count;
+        for(auto & ring : header->rings){
+            ring.head.store(0, std::memory_order_relaxed);
+            ring.tail.store(0, std::memory_order_relaxed);
+            ring.sequence.store(0, std::memory_order_relaxed);
+            ring.is_waiting.store(0, std::memory_order_relaxed);
+        }
+        // magic last, peer must not see a half initialized header.
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = SHM_MAGIC;
+
+        peer_id = 0;
+
+        return 0;
+    }
+
+    int SharedMemorySocket::attach(int fd) {
+        if(is_active) return -1;
+
+        auto dup_fd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if(dup_fd < 0) return -1;
+        if(map(dup_fd, false) < 0){
+            ::close(dup_fd);
+            return -1;
+        }
+
+        peer_id = 1;
+
+        return 0;
+    }
+
+    int SharedMemorySocket::close() {
+        if(!is_active) return -1;
+
+        ::munmap(shm_base, shm_size);
+        auto res = ::close(shm_fd);
+
+        shm_fd = -1;
+        shm_base = nullptr;
+        shm_size = 0;
+        is_active = false;
+
+        return res;
+    }
+
+    ssize_t SharedMemorySocket::send(const SharedMemoryPeer & target, const Buffer & src_buf, size_t size) const {
+        if(!is_active) return -1;
+        if(target.get_peer_id() != (peer_id ^ 1)){
+            errno = EINVAL;
+            return -1;
+        }
+
+        auto * header = (ShmHeader *)shm_base;
+        auto & ring = header->rings[peer_id];
+
+        if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+        if(size > header->slot_size) size = header->slot_size;
+
+        // only this side writes head.
+        auto head = ring.head.load(std::memory_order_relaxed);
+        if(head - ring.tail.load(std::memory_order_acquire) == header->slot_count){
+            errno = EAGAIN;
+            return -1;
+        }
+
+        auto * slot = get_slot(shm_base, header, peer_id, head);
+        auto size_tmp = uint64_t(size);
+        std::memcpy(slot, &size_tmp, sizeof(uint64_t));
+        std::memcpy(slot + sizeof(uint64_t), src_buf.get_buf_base(), size);
+
+        // seq_cst pairs with receiver setting is_waiting then re-reading head.
+        ring.head.store(head + 1, std::memory_order_seq_cst);
+        // a sleeping receiver is woken whatever mode this side polls in.
+        if(ring.is_waiting.load(std::memory_order_seq_cst) != 0){
+            ring.sequence.fetch_add(1, std::memory_order_seq_cst);
+            futex_wake(&ring.sequence);
+        }
+
+        return ssize_t(size);
+    }
+
+    ssize_t SharedMemorySocket::try_receive(SharedMemoryPeer & target) const {
+        if(!is_active) return -1;
+
+        auto * header = (ShmHeader *)shm_base;
+        auto ring_id = peer_id ^ 1;
+        auto & ring = header->rings[ring_id];
+
+        // only this side writes tail.
+        auto tail = ring.tail.load(std::memory_order_relaxed);
+        if(ring.head.load(std::memory_order_acquire) == tail){
+            errno = EAGAIN;
+            return -1;
+        }
+
+        const auto * slot = get_slot(shm_base, header, ring_id, tail);
+        auto size = uint64_t();
+        std::memcpy(&size, slot, sizeof(uint64_t));
+        if(size > header->slot_size) size = header->slot_size;
+
+        auto copy_size = size < buffer.get_buf_size() ? size : buffer.get_buf_size();
+        std::memcpy((void *)buffer.get_buf_base(), slot + sizeof(uint64_t), copy_size);
+
+        ring.tail.store(tail + 1, std::memory_order_release);
+
+        target = SharedMemoryPeer(ring_id);
+
+        return ssize_t(copy_size);
+    }
+
+    ssize_t SharedMemorySocket::receive(SharedMemoryPeer & target) const {
+        if(!is_active) return -1;
+
+        auto * header = (ShmHeader *)shm_base;
+        auto & ring = header->rings[peer_id ^ 1];
+
+        auto spin_count = 0;
+        while(true){
+            auto tail = ring.tail.load(std::memory_order_relaxed);
+            if(ring.head.load(std::memory_order_acquire) != tail) break;
+
+            if(wait_mode == SharedMemoryWaitMode::BUSY_POLL || spin_count < SPIN_LIMIT){
+                spin_count ++;
+                cpu_relax();
+                continue;
+            }
+
+            auto sequence = ring.sequence.load(std::memory_order_seq_cst);
+            ring.is_waiting.store(1, std::memory_order_seq_cst);
+            if(ring.head.load(std::memory_order_seq_cst) == tail) futex_wait(&ring.sequence, sequence);
+            ring.is_waiting.store(0, std::memory_order_relaxed);
+        }
+
+        return try_receive(target);
+    }
+
+    std::ostream & operator<<(std::ostream & ost, const SharedMemorySocket & shared_memory_socket) {
+        ost << shared_memory_socket.shm_fd << " - " << shared_memory_socket.get_socket_address() << " , ";
+
+        if(shared_memory_socket.is_active) return ost << "active";
+        return ost << "closed";
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 #include "socket_address.hpp"
 #include <iostream>
+#include <string>
 
 /* -------------------------------------------------------------------------------- */
 
@@ -31,6 +32,16 @@ namespace EZSock {
         return ost << "IPv4@" << socket_address_ipv4.ip << ":" << socket_address_ipv4.port;
     }
 
+/* -------------------------------------------------------------------------------- */
+
+    // SocketAddress_Unix
+
+    std::ostream & operator<<(std::ostream & ost, const SocketAddress_Unix & socket_address_unix) {
+        ost << "UNIX@";
+        if(socket_address_unix.is_abstract()) return ost << "@" << std::string(socket_address_unix.path + 1, socket_address_unix.path_size - 1);
+        return ost << std::string(socket_address_unix.path, socket_address_unix.path_size);
+    }
+
 }
 
 /* -------------------------------------------------------------------------------- */
\ No newline at end of file
@@ -0,0 +1,255 @@
+/*
+ * @file timer_wheel.cpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-08
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#include "timer_wheel.hpp"
+#include <climits>
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // TimerWheel
+
+    TimerWheel::TimerWheel(Clock::duration src_tick_duration) : tick_duration(src_tick_duration), start_time(Clock::now()), current_tick(0), nodes(), free_head(NIL), timer_count(0) {
+        for(auto & head : list_heads) head = NIL;
+        for(auto & bitmap : slot_bitmaps){
+            for(auto & word : bitmap) word = 0;
+        }
+    }
+
+    uint32_t TimerWheel::alloc_node() {
+        if(free_head != NIL){
+            auto index = free_head;
+            free_head = nodes[index].next;
+            return index;
+        }
+
+        nodes.push_back(TimerNode{0, NIL, NIL, NIL, 0, false, nullptr});
+        return uint32_t(nodes.size() - 1);
+    }
+
+    void TimerWheel::free_node(uint32_t index) noexcept {
+        auto & node = nodes[index];
+        node.is_active = false;
+        node.generation ++;
+        node.list = NIL;
+        node.prev = NIL;
+        node.next = free_head;
+        free_head = index;
+    }
+
+    void TimerWheel::link(uint32_t index, uint32_t list) noexcept {
+        auto & node = nodes[index];
+        node.list = list;
+        node.prev = NIL;
+        node.next = list_heads[list];
+
+        if(node.next != NIL) nodes[node.next].prev = index;
+        else if(list < SLOT_COUNT) slot_bitmaps[list / WHEEL_SIZE][(list % WHEEL_SIZE) / 64] |= uint64_t(1) << (list % 64);
+
+        list_heads[list] = index;
+    }
+
+    void TimerWheel::unlink(uint32_t index) noexcept {
+        auto & node = nodes[index];
+
+        if(node.prev != NIL) nodes[node.prev].next = node.next;
+        else list_heads[node.list] = node.next;
+
+        if(node.next != NIL) nodes[node.next].prev = node.prev;
+
+        if(list_heads[node.list] == NIL && node.list < SLOT_COUNT){
+            slot_bitmaps[node.list / WHEEL_SIZE][(node.list % WHEEL_SIZE) / 64] &= ~(uint64_t(1) << (node.list % 64));
+        }
+
+        node.list = NIL;
+    }
+
+    void TimerWheel::place(uint32_t index, uint64_t reference_tick) noexcept {
+        auto expire_tick = nodes[index].expire_tick;
+
+        // already due (e.g. re-placed late by cascade), current level 0 slot fires on this expiry pass.
+        if(expire_tick < reference_tick){
+            link(index, uint32_t(reference_tick) & WHEEL_MASK);
+            return;
+        }
+
+        // the lowest level whose upper bits agree with reference tick holds the timer.
+        for(uint32_t level = 0; level < WHEEL_LEVELS; level ++){
+            auto shift = WHEEL_BITS * (level + 1);
+            if((expire_tick >> shift) == (reference_tick >> shift)){
+                auto slot = uint32_t(expire_tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+                link(index, level * WHEEL_SIZE + slot);
+                return;
+            }
+        }
+
+        // too far away, park in top level slot 0 : it is cascaded exactly when the top level wraps, and holds nothing else.
+        link(index, (WHEEL_LEVELS - 1) * WHEEL_SIZE);
+    }
+
+    void TimerWheel::cascade(uint32_t level, uint64_t tick) noexcept {
+        auto list = level * WHEEL_SIZE + (uint32_t(tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+
+        // detach whole slot first, so that re-placing into the same slot is safe.
+        auto index = list_heads[list];
+        list_heads[list] = NIL;
+        slot_bitmaps[level][(list % WHEEL_SIZE) / 64] &= ~(uint64_t(1) << (list % 64));
+
+        while(index != NIL){
+            auto next = nodes[index].next;
+            place(index, tick);
+            index = next;
+        }
+    }
+
+    size_t TimerWheel::fire(uint32_t slot) {
+        // move slot to expiring list, so that callbacks can cancel timers of same batch.
+        auto index = list_heads[slot];
+        list_heads[slot] = NIL;
+        slot_bitmaps[0][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+
+        list_heads[EXPIRING_LIST] = index;
+        while(index != NIL){
+            nodes[index].list = EXPIRING_LIST;
+            index = nodes[index].next;
+        }
+
+        auto fired = size_t(0);
+        while(list_heads[EXPIRING_LIST] != NIL){
+            index = list_heads[EXPIRING_LIST];
+            unlink(index);
+
+            auto callback = std::move(nodes[index].callback);
+            nodes[index].callback = nullptr;
+            free_node(index);
+            timer_count --;
+
+            if(callback) callback();
+            fired ++;
+        }
+
+        return fired;
+    }
+
+    TimerHandle TimerWheel::add_timer_at(uint64_t expire_tick, Callback callback) {
+        auto index = alloc_node();
+        auto & node = nodes[index];
+
+        node.expire_tick = expire_tick > current_tick ? expire_tick : current_tick + 1;
+        node.is_active = true;
+        node.callback = std::move(callback);
+
+        place(index, current_tick);
+        timer_count ++;
+
+        return TimerHandle(index, node.generation);
+    }
+
+    bool TimerWheel::cancel_timer(TimerHandle & handle) noexcept {
+        if(!handle.is_valid() || handle.index >= nodes.size()) return false;
+
+        auto & node = nodes[handle.index];
+        if(!node.is_active || node.generation != handle.generation) return false;
+
+        unlink(handle.index);
+        node.callback = nullptr;
+        free_node(handle.index);
+        timer_count --;
+
+        handle = TimerHandle();
+
+        return true;
+    }
+
+    size_t TimerWheel::expire(uint64_t now_tick) {
+        auto fired = size_t(0);
+
+        while(current_tick < now_tick){
+            if(timer_count == 0){
+                current_tick = now_tick;
+                break;
+            }
+
+            auto next_tick = current_tick + 1;
+
+            if((next_tick & WHEEL_MASK) == 0){
+                // entering a new round of level 0, cascade from the highest level that wraps.
+                auto top_level = uint32_t(1);
+                while(top_level + 1 < WHEEL_LEVELS && ((next_tick >> (WHEEL_BITS * top_level)) & WHEEL_MASK) == 0) top_level ++;
+                for(auto level = top_level; level >= 1; level --) cascade(level, next_tick);
+
+                current_tick = next_tick;
+                if(list_heads[0] != NIL) fired += fire(0);
+                continue;
+            }
+
+            // skip empty slots of level 0 in one step.
+            auto slot = find_slot(0, uint32_t(next_tick) & WHEEL_MASK);
+            if(slot == WHEEL_SIZE){
+                auto round_end = (next_tick | WHEEL_MASK);
+                if(round_end >= now_tick){
+                    current_tick = now_tick;
+                    break;
+                }
+                current_tick = round_end;
+                continue;
+            }
+
+            auto slot_tick = (next_tick & ~uint64_t(WHEEL_MASK)) | slot;
+            if(slot_tick > now_tick){
+                current_tick = now_tick;
+                break;
+            }
+
+            current_tick = slot_tick;
+            fired += fire(slot);
+        }
+
+        return fired;
+    }
+
+    int64_t TimerWheel::get_next_timeout_ticks() const noexcept {
+        if(timer_count == 0) return -1;
+
+        for(uint32_t level = 0; level < WHEEL_LEVELS; level ++){
+            auto shift = WHEEL_BITS * level;
+            auto slot = find_slot(level, (uint32_t(current_tick >> shift) & WHEEL_MASK) + 1);
+            if(slot == WHEEL_SIZE) continue;
+
+            auto round_base = (current_tick >> (shift + WHEEL_BITS)) << (shift + WHEEL_BITS);
+            return int64_t(round_base + (uint64_t(slot) << shift) - current_tick);
+        }
+
+        // only parked timers left, wake up when the top level wraps.
+        auto wrap_shift = WHEEL_BITS * WHEEL_LEVELS;
+        return int64_t((((current_tick >> wrap_shift) + 1) << wrap_shift) - current_tick);
+    }
+
+    int TimerWheel::get_next_timeout() const noexcept {
+        auto ticks = get_next_timeout_ticks();
+        if(ticks < 0) return -1;
+
+        auto now_tick = get_now_tick();
+        auto deadline_tick = current_tick + uint64_t(ticks);
+        if(deadline_tick <= now_tick) return 0;
+
+        auto remaining = (deadline_tick - now_tick) * tick_duration;
+        auto remaining_ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+        return remaining_ms > INT_MAX ? INT_MAX : int(remaining_ms);
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
\ No newline at end of file
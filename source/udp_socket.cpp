@@ -9,6 +9,11 @@
  */
 
 #include "udp_socket.hpp"
+#include "timer_wheel.hpp"
+#include <netinet/in.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 
 /* -------------------------------------------------------------------------------- */
@@ -23,6 +28,28 @@ static void in_addr_clear(sockaddr_in * sa_ptr) noexcept {
     }
 }
 
+// to fill in ip_mreq struct with group & interface.
+static ip_mreq make_ip_mreq(const EZSock::IPv4_Address & group, const EZSock::IPv4_Address & interface) noexcept {
+    auto res = ip_mreq();
+    res.imr_multiaddr.s_addr = htonl(group.get());
+    res.imr_interface.s_addr = htonl(interface.get());
+
+    return res;
+}
+
+// to fill in ip_mreq_source struct with group, source & interface.
+static ip_mreq_source make_ip_mreq_source(const EZSock::IPv4_Address & group, const EZSock::IPv4_Address & source, const EZSock::IPv4_Address & interface) noexcept {
+    auto res = ip_mreq_source();
+    res.imr_multiaddr.s_addr = htonl(group.get());
+    res.imr_sourceaddr.s_addr = htonl(source.get());
+    res.imr_interface.s_addr = htonl(interface.get());
+
+    return res;
+}
+
+// max number of messages passed to a single sendmmsg call.
+static constexpr size_t SENDMMSG_BATCH_SIZE = 1024;
+
 /* -------------------------------------------------------------------------------- */
 
 namespace EZSock {
@@ -50,6 +77,165 @@ namespace EZSock {
         return ::bind(socket, sockaddr_ptr, sizeof(sockaddr));
     }
 
+    ssize_t UDPSocket::receive(SocketAddress_IPv4 & target, TimerWheel & timer_wheel, bool is_blocking) const {
+        if(!is_active) return -1;
+
+        auto sockaddr_tmp = sockaddr();
+        auto socklen_tmp = socklen_t(sizeof(sockaddr));
+
+        while(true){
+            timer_wheel.expire();
+
+            if(!is_blocking){
+                socklen_tmp = socklen_t(sizeof(sockaddr));
+                auto res = ::recvfrom(socket, (void *)buffer.get_buf_base(), buffer.get_buf_size(), MSG_DONTWAIT, &sockaddr_tmp, &socklen_tmp);
+                if(res >= 0) target = SocketAddress_IPv4(sockaddr_tmp);
+                return res;
+            }
+
+            auto pollfd_tmp = pollfd{socket, POLLIN, 0};
+            auto poll_res = ::poll(&pollfd_tmp, 1, timer_wheel.get_next_timeout());
+            if(poll_res < 0 && errno != EINTR) return -1;
+            if(poll_res <= 0) continue;
+
+            socklen_tmp = socklen_t(sizeof(sockaddr));
+            auto res = ::recvfrom(socket, (void *)buffer.get_buf_base(), buffer.get_buf_size(), MSG_DONTWAIT, &sockaddr_tmp, &socklen_tmp);
+            if(res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+            if(res >= 0) target = SocketAddress_IPv4(sockaddr_tmp);
+            return res;
+        }
+    }
+
+    ssize_t UDPSocket::receive(SocketAddress_IPv4 & target, IPv4_Address & destination) const {
+        if(!is_active) return -1;
+
+        auto sockaddr_tmp = sockaddr();
+        auto iovec_tmp = iovec{(void *)buffer.get_buf_base(), buffer.get_buf_size()};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(in_pktinfo))];
+
+        auto msghdr_tmp = msghdr();
+        msghdr_tmp.msg_name = &sockaddr_tmp;
+        msghdr_tmp.msg_namelen = socklen_t(sizeof(sockaddr));
+        msghdr_tmp.msg_iov = &iovec_tmp;
+        msghdr_tmp.msg_iovlen = 1;
+        msghdr_tmp.msg_control = control;
+        msghdr_tmp.msg_controllen = sizeof(control);
+
+        auto res = ::recvmsg(socket, &msghdr_tmp, 0);
+        if(res < 0) return res;
+
+        target = SocketAddress_IPv4(sockaddr_tmp);
+        destination = IPv4_Address();
+
+        for(auto cmsg_ptr = CMSG_FIRSTHDR(&msghdr_tmp); cmsg_ptr != nullptr; cmsg_ptr = CMSG_NXTHDR(&msghdr_tmp, cmsg_ptr)){
+            if(cmsg_ptr->cmsg_level != IPPROTO_IP || cmsg_ptr->cmsg_type != IP_PKTINFO) continue;
+
+            auto pktinfo_tmp = in_pktinfo();
+            std::memcpy(&pktinfo_tmp, CMSG_DATA(cmsg_ptr), sizeof(in_pktinfo));
+            destination = IPv4_Address(ntohl(pktinfo_tmp.ipi_addr.s_addr));
+        }
+
+        return res;
+    }
+
+    ssize_t UDPSocket::send_to_all(const std::vector<SocketAddress_IPv4> & targets, const Buffer & src_buf, size_t size) const {
+        if(!is_active) return -1;
+        if(targets.empty()) return 0;
+
+        if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+
+        // all messages share one iovec, only destination differs.
+        auto iovec_tmp = iovec{(void *)src_buf.get_buf_base(), size};
+        auto batch_size = targets.size() < SENDMMSG_BATCH_SIZE ? targets.size() : SENDMMSG_BATCH_SIZE;
+        auto sockaddrs = std::vector<sockaddr>(batch_size);
+        auto mmsghdrs = std::vector<mmsghdr>(batch_size);
+
+        auto sent = size_t(0);
+        while(sent < targets.size()){
+            auto count = targets.size() - sent < batch_size ? targets.size() - sent : batch_size;
+
+            for(size_t i = 0; i < count; i ++){
+                sockaddrs[i] = sockaddr(targets[sent + i]);
+                mmsghdrs[i] = mmsghdr();
+                mmsghdrs[i].msg_hdr.msg_name = &sockaddrs[i];
+                mmsghdrs[i].msg_hdr.msg_namelen = socklen_t(sizeof(sockaddr));
+                mmsghdrs[i].msg_hdr.msg_iov = &iovec_tmp;
+                mmsghdrs[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            auto res = ::sendmmsg(socket, mmsghdrs.data(), (unsigned int)count, 0);
+            if(res < 0){
+                if(errno == EINTR) continue;
+                return sent == 0 ? -1 : ssize_t(sent);
+            }
+
+            // a partial batch means the next message failed, report what got through.
+            sent += size_t(res);
+            if(size_t(res) < count) break;
+        }
+
+        return ssize_t(sent);
+    }
+
+    int UDPSocket::join_group(const IPv4_Address & group, const IPv4_Address & interface) {
+        auto mreq_tmp = make_ip_mreq(group, interface);
+        auto res = ::setsockopt(socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq_tmp, sizeof(ip_mreq));
+        if(res < 0) return res;
+
+        // let kernel drop groups this socket did not join, and report group of each datagram.
+        set_multicast_all(false);
+        return set_packet_info(true);
+    }
+
+    int UDPSocket::leave_group(const IPv4_Address & group, const IPv4_Address & interface) {
+        auto mreq_tmp = make_ip_mreq(group, interface);
+        return ::setsockopt(socket, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mreq_tmp, sizeof(ip_mreq));
+    }
+
+    int UDPSocket::join_source_group(const IPv4_Address & group, const IPv4_Address & source, const IPv4_Address & interface) {
+        auto mreq_tmp = make_ip_mreq_source(group, source, interface);
+        auto res = ::setsockopt(socket, IPPROTO_IP, IP_ADD_SOURCE_MEMBERSHIP, &mreq_tmp, sizeof(ip_mreq_source));
+        if(res < 0) return res;
+
+        set_multicast_all(false);
+        return set_packet_info(true);
+    }
+
+    int UDPSocket::leave_source_group(const IPv4_Address & group, const IPv4_Address & source, const IPv4_Address & interface) {
+        auto mreq_tmp = make_ip_mreq_source(group, source, interface);
+        return ::setsockopt(socket, IPPROTO_IP, IP_DROP_SOURCE_MEMBERSHIP, &mreq_tmp, sizeof(ip_mreq_source));
+    }
+
+    int UDPSocket::set_multicast_ttl(uint8_t ttl) {
+        auto ttl_tmp = int(ttl);
+        return ::setsockopt(socket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl_tmp, sizeof(int));
+    }
+
+    int UDPSocket::set_multicast_loop(bool is_enabled) {
+        auto loop_tmp = int(is_enabled);
+        return ::setsockopt(socket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop_tmp, sizeof(int));
+    }
+
+    int UDPSocket::set_multicast_interface(const IPv4_Address & interface) {
+        auto in_addr_tmp = in_addr();
+        in_addr_tmp.s_addr = htonl(interface.get());
+        return ::setsockopt(socket, IPPROTO_IP, IP_MULTICAST_IF, &in_addr_tmp, sizeof(in_addr));
+    }
+
+    int UDPSocket::set_multicast_all(bool is_enabled) {
+#ifdef IP_MULTICAST_ALL
+        auto all_tmp = int(is_enabled);
+        return ::setsockopt(socket, IPPROTO_IP, IP_MULTICAST_ALL, &all_tmp, sizeof(int));
+#else
+        return is_enabled ? 0 : -1;
+#endif
+    }
+
+    int UDPSocket::set_packet_info(bool is_enabled) {
+        auto pktinfo_tmp = int(is_enabled);
+        return ::setsockopt(socket, IPPROTO_IP, IP_PKTINFO, &pktinfo_tmp, sizeof(int));
+    }
+
     inline std::ostream & operator<<(std::ostream & ost, const UDPSocket & udp_socket) {
         ost << udp_socket.socket << " - " << udp_socket.get_socket_address() << " , ";
 
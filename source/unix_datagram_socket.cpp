@@ -0,0 +1,176 @@
+/*
+ * @file unix_datagram_socket.cpp
+ * @author __NYA__
+ * @version 0.1
+ * @date 2022-10-16
+ *
+ * @copyright Copyright (c) 2022 __NYA__
+ *
+ */
+
+#include "unix_datagram_socket.hpp"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <iostream>
+
+/* -------------------------------------------------------------------------------- */
+
+namespace EZSock {
+
+/* -------------------------------------------------------------------------------- */
+
+    // UnixDatagramSocket
+
+    void UnixDatagramSocket::adopt(int src_socket) noexcept {
+        if(socket >= 0) ::close(socket);
+
+        socket = src_socket;
+        socket_address_unix = SocketAddress_Unix();
+        is_active = true;
+    }
+
+    int UnixDatagramSocket::bind(const SocketAddress_Unix & address) {
+        if(is_active) return -1;
+
+        auto sockaddr_tmp = sockaddr_un(address);
+        auto res = ::bind(socket, (sockaddr *)&sockaddr_tmp, address.get_sockaddr_size());
+        if(res < 0) return res;
+
+        is_active = true;
+
+        // to learn autobound name.
+        auto socklen_tmp = socklen_t(sizeof(sockaddr_un));
+        if(::getsockname(socket, (sockaddr *)&sockaddr_tmp, &socklen_tmp) == 0) socket_address_unix = SocketAddress_Unix(sockaddr_tmp, socklen_tmp);
+        else socket_address_unix = address;
+
+        return res;
+    }
+
+    int UnixDatagramSocket::connect(const SocketAddress_Unix & address) {
+        auto sockaddr_tmp = sockaddr_un(address);
+        auto res = ::connect(socket, (sockaddr *)&sockaddr_tmp, address.get_sockaddr_size());
+        if(res == 0) is_active = true;
+
+        return res;
+    }
+
+    int UnixDatagramSocket::listen(int backlog) {
+        if(!is_active || socket_type != UnixSocketType::SEQPACKET) return -1;
+
+        return ::listen(socket, backlog);
+    }
+
+    int UnixDatagramSocket::accept(UnixDatagramSocket & peer) {
+        if(!is_active || peer.is_active) return -1;
+
+        auto res = ::accept4(socket, nullptr, nullptr, SOCK_CLOEXEC);
+        if(res < 0) return res;
+
+        peer.adopt(res);
+        peer.socket_type = socket_type;
+
+        return 0;
+    }
+
+    int UnixDatagramSocket::pair(UnixDatagramSocket & lhs, UnixDatagramSocket & rhs) {
+        if(lhs.is_active || rhs.is_active || lhs.socket_type != rhs.socket_type) return -1;
+
+        int sockets[2];
+        auto res = ::socketpair(AF_UNIX, int(lhs.socket_type) | SOCK_CLOEXEC, 0, sockets);
+        if(res < 0) return res;
+
+        lhs.adopt(sockets[0]);
+        rhs.adopt(sockets[1]);
+
+        return 0;
+    }
+
+    ssize_t UnixDatagramSocket::send_fd(const SocketAddress_Unix & target, int fd, const Buffer & src_buf, size_t size) const {
+        if(!is_active) return -1;
+
+        if(size > src_buf.get_buf_size()) size = src_buf.get_buf_size();
+
+        auto sockaddr_tmp = sockaddr_un(target);
+        auto iovec_tmp = iovec{(void *)src_buf.get_buf_base(), size};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+        auto msghdr_tmp = msghdr();
+        if(!target.is_empty()){
+            msghdr_tmp.msg_name = &sockaddr_tmp;
+            msghdr_tmp.msg_namelen = target.get_sockaddr_size();
+        }
+        msghdr_tmp.msg_iov = &iovec_tmp;
+        msghdr_tmp.msg_iovlen = 1;
+        msghdr_tmp.msg_control = control;
+        msghdr_tmp.msg_controllen = sizeof(control);
+
+        auto cmsg_ptr = CMSG_FIRSTHDR(&msghdr_tmp);
+        cmsg_ptr->cmsg_level = SOL_SOCKET;
+        cmsg_ptr->cmsg_type = SCM_RIGHTS;
+        cmsg_ptr->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg_ptr), &fd, sizeof(int));
+
+        return ::sendmsg(socket, &msghdr_tmp, MSG_NOSIGNAL);
+    }
+
+    ssize_t UnixDatagramSocket::receive_fd(SocketAddress_Unix & target, int & fd) const {
+        fd = -1;
+        if(!is_active) return -1;
+
+        auto sockaddr_tmp = sockaddr_un();
+        auto iovec_tmp = iovec{(void *)buffer.get_buf_base(), buffer.get_buf_size()};
+        // room for a few descriptors, extra ones are closed.
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 4)];
+
+        auto msghdr_tmp = msghdr();
+        msghdr_tmp.msg_name = &sockaddr_tmp;
+        msghdr_tmp.msg_namelen = socklen_t(sizeof(sockaddr_un));
+        msghdr_tmp.msg_iov = &iovec_tmp;
+        msghdr_tmp.msg_iovlen = 1;
+        msghdr_tmp.msg_control = control;
+        msghdr_tmp.msg_controllen = sizeof(control);
+
+        auto res = ::recvmsg(socket, &msghdr_tmp, MSG_CMSG_CLOEXEC);
+        if(res < 0) return res;
+
+        target = SocketAddress_Unix(sockaddr_tmp, msghdr_tmp.msg_namelen);
+
+        for(auto cmsg_ptr = CMSG_FIRSTHDR(&msghdr_tmp); cmsg_ptr != nullptr; cmsg_ptr = CMSG_NXTHDR(&msghdr_tmp, cmsg_ptr)){
+            if(cmsg_ptr->cmsg_level != SOL_SOCKET || cmsg_ptr->cmsg_type != SCM_RIGHTS) continue;
+
+            auto fd_count = (cmsg_ptr->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for(size_t i = 0; i < fd_count; i ++){
+                auto fd_tmp = int();
+                std::memcpy(&fd_tmp, CMSG_DATA(cmsg_ptr) + i * sizeof(int), sizeof(int));
+                if(fd < 0) fd = fd_tmp;
+                else ::close(fd_tmp);
+            }
+        }
+
+        return res;
+    }
+
+    int UnixDatagramSocket::create_memfd(const char * name, size_t size) {
+        auto fd = ::memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if(fd < 0) return -1;
+
+        if(::ftruncate(fd, off_t(size)) < 0 || ::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0){
+            ::close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    std::ostream & operator<<(std::ostream & ost, const UnixDatagramSocket & unix_datagram_socket) {
+        ost << unix_datagram_socket.socket << " - " << unix_datagram_socket.get_socket_address() << " , ";
+
+        if(unix_datagram_socket.is_active) return ost << "active";
+        return ost << "closed";
+    }
+
+/* -------------------------------------------------------------------------------- */
+
+}
+
+/* -------------------------------------------------------------------------------- */
\ No newline at end of file